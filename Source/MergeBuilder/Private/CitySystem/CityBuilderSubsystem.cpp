@@ -3,7 +3,7 @@
 
 #include "CitySystem/CityBuilderSubsystem.h"
 #include "MBUtilityFunctionLibrary.h"
-#include "JsonObjectConverter.h"
+#include "Utilities/MBJsonCodec.h"
 #include "TimeSubsystem.h"
 #include "Analytics/FGAnalytics.h"
 #include "Analytics/FGAnalyticsParameter.h"
@@ -22,6 +22,11 @@ UCityBuilderSubsystem::UCityBuilderSubsystem()
 
 void UCityBuilderSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
+	// generator restore deadlines are scheduled on init
+	Collection.InitializeDependency(UTimeSubsystem::StaticClass());
+
+	ObjectsIndex.Build(CityObjectsDataTable);
+
 	InitCity();
 	CreateConsoleVariables();
 }
@@ -35,7 +40,7 @@ void UCityBuilderSubsystem::GetCityObjectsByType(ECityObjectCategory Type, TArra
 {
 	for (const auto& CityObject : CityObjects)
 	{
-		const FCityObjectData* RowStruct = CityObjectsDataTable->FindRow<FCityObjectData>(CityObject.ObjectName, "");
+		const FCityObjectData* RowStruct = ObjectsIndex.FindRow(CityObject.ObjectName);
 
 		if (!RowStruct)
 			continue;
@@ -54,7 +59,8 @@ void UCityBuilderSubsystem::AddNewObject(FCityObject& NewCityObject)
 	NewCityObject.ObjectID = ID;
 
 	AddExperienceForNewObject(NewCityObject.ObjectName);
-	CalculateCurrentPopulationAndRatings();
+	ApplyObjectToPopulationAndRatings(NewCityObject.ObjectName, true);
+	VerifyPopulationAndRatings();
 
 	UFGAnalyticsParameter* Param = NewObject<UFGAnalyticsParameter>();
 	Param->SetName("object_name");
@@ -66,66 +72,144 @@ void UCityBuilderSubsystem::AddNewObject(FCityObject& NewCityObject)
 
 void UCityBuilderSubsystem::EditObject(const FCityObject& EditedObject)
 {
+	const FName OldObjectName = CityObjects[EditedObject.ObjectID].ObjectName;
+
 	CityObjects[EditedObject.ObjectID] = EditedObject;
+
+	if (OldObjectName != EditedObject.ObjectName)
+	{
+		ApplyObjectToPopulationAndRatings(OldObjectName, false);
+		ApplyObjectToPopulationAndRatings(EditedObject.ObjectName, true);
+		VerifyPopulationAndRatings();
+	}
+
+	ScheduleGeneratorRestore(EditedObject.ObjectID);
 }
 
 void UCityBuilderSubsystem::RemoveObject(const FCityObject& ObjectToRemove)
 {
+	ApplyObjectToPopulationAndRatings(CityObjects[ObjectToRemove.ObjectID].ObjectName, false);
 	CityObjects[ObjectToRemove.ObjectID].ObjectName = NAME_None;
 
-	CalculateCurrentPopulationAndRatings();
+	int32 DeadlineID;
+	if (RestoreDeadlines.RemoveAndCopyValue(ObjectToRemove.ObjectID, DeadlineID))
+	{
+		GetGameInstance()->GetSubsystem<UTimeSubsystem>()->RemoveDeadline(DeadlineID);
+	}
+
+	VerifyPopulationAndRatings();
 }
 
-void UCityBuilderSubsystem::CollectFromObject(FCityObject& Object)
+bool UCityBuilderSubsystem::CollectFromObject(FCityObject& Object)
 {
 	auto TimeSubsystem = GetGameInstance()->GetSubsystem<UTimeSubsystem>();
 	auto MergeSubsystem = GetGameInstance()->GetSubsystem<UMergeSubsystem>();
-	
-	check(CityObjects[Object.ObjectID].RestoreTime < TimeSubsystem->GetUTCNow());
 
-	const FCityObjectData* RowStruct = CityObjectsDataTable->FindRow<FCityObjectData>(Object.ObjectName, "");
+	// generators are restored only by time confirmed by server, device clock can be moved forward
+	if (!TimeSubsystem->IsTimeVerified() || CityObjects[Object.ObjectID].RestoreTime >= TimeSubsystem->GetUTCNow())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UCityBuilderSubsystem::CollectFromObject() - Object %d is not restored yet"), Object.ObjectID);
+		return false;
+	}
+
+	const FCityObjectData* RowStruct = ObjectsIndex.FindRow(Object.ObjectName);
 
 	MergeSubsystem->AddNewReward(RowStruct->GeneratorSettings.GeneratedBox);
 
 	FTimespan RestoreDuration = FTimespan::FromSeconds(RowStruct->GeneratorSettings.MinutesToRestore * 60);
 	CityObjects[Object.ObjectID].RestoreTime = TimeSubsystem->GetUTCNow() + RestoreDuration;
 	Object = CityObjects[Object.ObjectID];
+
+	ScheduleGeneratorRestore(Object.ObjectID);
+
+	return true;
 }
 
-void UCityBuilderSubsystem::ParseCity(const FString& JsonString)
+void UCityBuilderSubsystem::ScheduleGeneratorRestore(int32 ObjectID)
 {
-	TSharedPtr<FJsonObject> JsonObject;
+	auto TimeSubsystem = GetGameInstance()->GetSubsystem<UTimeSubsystem>();
 
-	if (!UMBUtilityFunctionLibrary::StringToJsonObject(JsonString, JsonObject))
+	int32 OldDeadlineID;
+	if (RestoreDeadlines.RemoveAndCopyValue(ObjectID, OldDeadlineID))
+	{
+		TimeSubsystem->RemoveDeadline(OldDeadlineID);
+	}
+
+	const FDateTime RestoreTime = CityObjects[ObjectID].RestoreTime;
+
+	// generator was never collected or is already restored
+	if (RestoreTime == FDateTime(0))
 		return;
 
-	const TArray<TSharedPtr<FJsonValue>>* CityObjectsJsonArray;
+	if (TimeSubsystem->IsTimeVerified() && RestoreTime <= TimeSubsystem->GetUTCNow())
+		return;
 
-	if (JsonObject.Get()->TryGetArrayField("cityObjects", CityObjectsJsonArray))
+	FSimpleDelegate Callback = FSimpleDelegate::CreateWeakLambda(this, [this, ObjectID]()
 	{
-		CityObjects.Empty();
-		for (const auto& CityObjectValue : *CityObjectsJsonArray)
+		RestoreDeadlines.Remove(ObjectID);
+		OnGeneratorRestored.Broadcast(ObjectID);
+	});
+
+	RestoreDeadlines.Add(ObjectID, TimeSubsystem->AddDeadline(RestoreTime, Callback));
+}
+
+void UCityBuilderSubsystem::ParseCity(const FString& JsonString)
+{
+	auto Reader = FMBJsonCodec::CreateReader(JsonString);
+
+	EJsonNotation Notation;
+	if (!Reader->ReadNext(Notation) || Notation != EJsonNotation::ObjectStart)
+		return;
+
+	while (Reader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
+	{
+		if (Reader->GetIdentifier() == "cityObjects" && Notation == EJsonNotation::ArrayStart)
 		{
-			FCityObject Item;
-			FJsonObjectConverter::JsonObjectToUStruct<FCityObject>(CityObjectValue->AsObject().ToSharedRef(), &Item);
+			CityObjects.Empty();
+			FMBJsonCodec::ReadStructArray(*Reader, CityObjects);
 
-			int32 ID = CityObjects.Add(Item);
-			CityObjects[ID].ObjectID = ID;
+			for (int32 ID = 0; ID < CityObjects.Num(); ID++)
+			{
+				CityObjects[ID].ObjectID = ID;
+			}
+		}
+		else
+		{
+			FMBJsonCodec::SkipValue(*Reader, Notation);
 		}
 	}
 }
 
 void UCityBuilderSubsystem::InitCity()
 {
-	FString SavedData;
-	if (!UMBUtilityFunctionLibrary::ReadFromStorage("City", SavedData))
+	const bool BinaryLoaded = UMBUtilityFunctionLibrary::ReadBinaryFromStorage("City", [this](FArchive& Ar, int32 Version)
 	{
-		FString StartCityJsonPath = FPaths::ProjectContentDir() + "/Jsons/StartCity.json";
-		FFileHelper::LoadFileToString(SavedData, *StartCityJsonPath);
+		SerializeCity(Ar, Version);
+	});
+
+	if (!BinaryLoaded)
+	{
+		// migrate city from json storage or start with the default city
+		FString SavedData;
+		if (!UMBUtilityFunctionLibrary::ReadFromStorage("City", SavedData))
+		{
+			FString StartCityJsonPath = FPaths::ProjectContentDir() + "/Jsons/StartCity.json";
+			FFileHelper::LoadFileToString(SavedData, *StartCityJsonPath);
+		}
+
+		ParseCity(SavedData);
+		SaveCity();
 	}
 
-	ParseCity(SavedData);
 	CalculateCurrentPopulationAndRatings();
+
+	for (const auto& CityObject : CityObjects)
+	{
+		if (CityObject.ObjectName != NAME_None)
+		{
+			ScheduleGeneratorRestore(CityObject.ObjectID);
+		}
+	}
 }
 
 void UCityBuilderSubsystem::CreateConsoleVariables()
@@ -141,53 +225,126 @@ void UCityBuilderSubsystem::CreateConsoleVariables()
 
 void UCityBuilderSubsystem::SaveCity()
 {
-	TSharedPtr<FJsonObject> JsonObject = MakeShared<FJsonObject>();
+	UMBUtilityFunctionLibrary::SaveBinaryToStorage("City", CityStorageVersion, [this](FArchive& Ar, int32 Version)
+	{
+		SerializeCity(Ar, Version);
+	});
 
-	TArray<TSharedPtr<FJsonValue>> CityJsonArray;
+	if (UMBUtilityFunctionLibrary::IsJsonExportEnabled())
+	{
+		ExportCityJson();
+	}
+}
+
+void UCityBuilderSubsystem::SerializeCity(FArchive& Ar, int32 Version)
+{
+	TArray<FCityObject> SavedObjects;
+
+	if (Ar.IsSaving())
+	{
+		SavedObjects = CityObjects.FilterByPredicate([](const FCityObject& Object)
+		{
+			return Object.ObjectName != NAME_None;
+		});
+	}
+
+	SerializeStructArray(Ar, SavedObjects);
+
+	if (Ar.IsLoading())
+	{
+		CityObjects = MoveTemp(SavedObjects);
+
+		for (int32 ID = 0; ID < CityObjects.Num(); ID++)
+		{
+			CityObjects[ID].ObjectID = ID;
+		}
+	}
+}
+
+void UCityBuilderSubsystem::ExportCityJson()
+{
+	FString StringData;
+	auto Writer = FMBJsonCodec::CreateWriter(StringData);
+
+	Writer->WriteObjectStart();
+	Writer->WriteArrayStart("cityObjects");
 
 	for (const auto& Object : CityObjects)
 	{
 		if (Object.ObjectName == NAME_None)
 			continue;
 
-		TSharedPtr<FJsonObject> CityJsonObject = FJsonObjectConverter::UStructToJsonObject<FCityObject>(Object);
-		TSharedPtr<FJsonValue> ObjectValue = MakeShared<FJsonValueObject>(CityJsonObject);
-
-		CityJsonArray.Add(ObjectValue);
+		FMBJsonCodec::WriteStruct(*Writer, Object);
 	}
 
-	JsonObject->SetArrayField("cityObjects", CityJsonArray);
-
-	FString StringData;
-	UMBUtilityFunctionLibrary::JsonObjectToString(JsonObject, StringData);
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
 
 	UMBUtilityFunctionLibrary::SaveToStorage("City", StringData);
 }
 
 void UCityBuilderSubsystem::CalculateCurrentPopulationAndRatings()
 {
-	int32 TotalPopulation = 1;
-	int32 TotalEmployed = 0;
-	FCityRatings NewRatings;
+	SumPopulationAndRatings(Population, EmployedPopulation, CityRating);
+}
+
+void UCityBuilderSubsystem::SumPopulationAndRatings(int32& OutPopulation, int32& OutEmployed, FCityRatings& OutRatings) const
+{
+	OutPopulation = 1;
+	OutEmployed = 0;
+	OutRatings = FCityRatings();
 
 	for (const auto& Object : CityObjects)
 	{
 		if (Object.ObjectName == NAME_None)
 			continue;
 
-		const FCityObjectData* RowStruct = CityObjectsDataTable->FindRow<FCityObjectData>(Object.ObjectName, "");
+		const FCityObjectData* RowStruct = ObjectsIndex.FindRow(Object.ObjectName);
 
 		if (!RowStruct)
 			continue;
 
-		TotalPopulation += RowStruct->AdditionalPopulation;
-		TotalEmployed += RowStruct->GeneratorSettings.RequiredEmployees;
-		NewRatings += RowStruct->AdditionalRatings;
+		OutPopulation += RowStruct->AdditionalPopulation;
+		OutEmployed += RowStruct->GeneratorSettings.RequiredEmployees;
+		OutRatings += RowStruct->AdditionalRatings;
+	}
+}
+
+void UCityBuilderSubsystem::ApplyObjectToPopulationAndRatings(const FName& ObjectName, bool bAdd)
+{
+	if (ObjectName == NAME_None)
+		return;
+
+	const FCityObjectData* RowStruct = ObjectsIndex.FindRow(ObjectName);
+
+	if (!RowStruct)
+		return;
+
+	if (bAdd)
+	{
+		Population += RowStruct->AdditionalPopulation;
+		EmployedPopulation += RowStruct->GeneratorSettings.RequiredEmployees;
+		CityRating += RowStruct->AdditionalRatings;
+	}
+	else
+	{
+		Population -= RowStruct->AdditionalPopulation;
+		EmployedPopulation -= RowStruct->GeneratorSettings.RequiredEmployees;
+		CityRating -= RowStruct->AdditionalRatings;
 	}
+}
 
-	Population = TotalPopulation;
-	EmployedPopulation = TotalEmployed;
-	CityRating = NewRatings;
+void UCityBuilderSubsystem::VerifyPopulationAndRatings() const
+{
+#if !UE_BUILD_SHIPPING
+	int32 TotalPopulation, TotalEmployed;
+	FCityRatings TotalRatings;
+	SumPopulationAndRatings(TotalPopulation, TotalEmployed, TotalRatings);
+
+	ensureMsgf(TotalPopulation == Population && TotalEmployed == EmployedPopulation && TotalRatings == CityRating,
+		TEXT("City population and ratings are out of sync with city objects"));
+#endif
 }
 
 void UCityBuilderSubsystem::GetTopRatingsForLevel(int32 Level, FCityRatings& TopRatings)
@@ -215,32 +372,20 @@ float UCityBuilderSubsystem::GetAverageRating()
 
 void UCityBuilderSubsystem::GetObjectsChain(const FName& ObjectName, TArray<FCityObjectData>& OutObjects, int32& CurrentIndex)
 {
-	FName PreviousObjectName = NAME_None;
 	FName CurrentObjectName = ObjectName;
-	do
-	{
-		TMap<FName, uint8*> RowsMap = CityObjectsDataTable->GetRowMap();
+	const FName RootObjectName = ObjectsIndex.GetChainRoot(ObjectName);
 
-		PreviousObjectName = NAME_None;
-		for (const auto& Row : RowsMap)
-		{
-			auto RowData = (FCityObjectData*)Row.Value;
-			
-			if (RowData->NextLevelObjectName == CurrentObjectName)
-			{
-				PreviousObjectName = Row.Key;
-				CurrentObjectName = Row.Key;
-				OutObjects.Insert(*RowData, 0);
-				break;
-			}
-		}
-	} while (PreviousObjectName != NAME_None);
+	while (CurrentObjectName != RootObjectName)
+	{
+		CurrentObjectName = ObjectsIndex.GetPreviousLevel(CurrentObjectName);
+		OutObjects.Insert(*ObjectsIndex.FindRow(CurrentObjectName), 0);
+	}
 
 	CurrentObjectName = ObjectName;
 	CurrentIndex = OutObjects.Num();
 	while(true)
 	{
-		auto Row = CityObjectsDataTable->FindRow<FCityObjectData>(CurrentObjectName, "");
+		auto Row = ObjectsIndex.FindRow(CurrentObjectName);
 
 		if (!Row)
 			break;
@@ -252,15 +397,11 @@ void UCityBuilderSubsystem::GetObjectsChain(const FName& ObjectName, TArray<FCit
 
 bool UCityBuilderSubsystem::HasGenerator(const FName& ObjectName)
 {
+	const TArray<FName>& GeneratorFamily = ObjectsIndex.GetGeneratorFamily(ObjectName);
+
 	for (const auto& Object : CityObjects)
 	{
-		if (Object.ObjectName == ObjectName)
-			return true;
-
-		if (Object.ObjectName == FName(ObjectName.ToString() + "2"))
-			return true;
-
-		if (Object.ObjectName == FName(ObjectName.ToString() + "3"))
+		if (Object.ObjectName == ObjectName || GeneratorFamily.Contains(Object.ObjectName))
 			return true;
 	}
 
@@ -347,17 +488,29 @@ void UCityBuilderSubsystem::SkipTimerForObject(int32 ObjectID)
 	AccountSubsystem->SpendPremCoins(Price);
 
 	CityObjects[ObjectID].RestoreTime = TimeSubsystem->GetUTCNow() - FTimespan::FromSeconds(1);
+
+	ScheduleGeneratorRestore(ObjectID);
+
+	OnGeneratorRestored.Broadcast(ObjectID);
 }
 
 void UCityBuilderSubsystem::HandleSuccessWatchVideoForObject(int32 ObjectID)
 {
 	FTimespan SkipTime = FTimespan::FromMinutes(AdSkipTimeSeconds);
 	CityObjects[ObjectID].RestoreTime -= SkipTime;
+
+	ScheduleGeneratorRestore(ObjectID);
+
+	// skip can restore generator right away
+	if (!RestoreDeadlines.Contains(ObjectID))
+	{
+		OnGeneratorRestored.Broadcast(ObjectID);
+	}
 }
 
 void UCityBuilderSubsystem::AddExperienceForNewObject(const FName& NewObjectName)
 {
-	const FCityObjectData* RowStruct = CityObjectsDataTable->FindRow<FCityObjectData>(NewObjectName, "");
+	const FCityObjectData* RowStruct = ObjectsIndex.FindRow(NewObjectName);
 
 	if (!RowStruct)
 		return;
@@ -393,11 +546,10 @@ bool UCityBuilderSubsystem::CheckRequierementsForBuildObject(const FName& Object
 	auto MergeSubsystem = GetGameInstance()->GetSubsystem<UMergeSubsystem>();
 	auto AccountSubsystem = GetGameInstance()->GetSubsystem<UAccountSubsystem>();
 
-	const FCityObjectData* RowStruct = CityObjectsDataTable->FindRow<FCityObjectData>(ObjectName, "");
+	const FCityObjectData* RowStruct = ObjectsIndex.FindRow(ObjectName);
 	check(RowStruct);
 
-	int32 UnemployedPopulation = FMath::Max(0, Population - EmployedPopulation);
-	if (RowStruct->GeneratorSettings.RequiredEmployees > UnemployedPopulation)
+	if (RowStruct->GeneratorSettings.RequiredEmployees > GetUnemployedPopulation())
 		return false;
 
 	for (const auto& Item : RowStruct->RequiredItems)
@@ -437,7 +589,7 @@ void UCityBuilderSubsystem::SpendResourcesForBuildObject(const FName& ObjectName
 	auto MergeSubsystem = GetGameInstance()->GetSubsystem<UMergeSubsystem>();
 	auto AccountSubsystem = GetGameInstance()->GetSubsystem<UAccountSubsystem>();
 
-	const FCityObjectData* RowStruct = CityObjectsDataTable->FindRow<FCityObjectData>(ObjectName, "");
+	const FCityObjectData* RowStruct = ObjectsIndex.FindRow(ObjectName);
 	check(RowStruct);
 
 	for (const auto& Item : RowStruct->RequiredItems)
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CitySystem/CityObjectsIndex.h"
+
+void FCityObjectsIndex::Build(const UDataTable* DataTable)
+{
+	Rows.Empty();
+	PreviousLevels.Empty();
+	ChainRoots.Empty();
+	GeneratorFamilies.Empty();
+	QuestObjects.Empty();
+
+	for (const auto& Row : DataTable->GetRowMap())
+	{
+		auto RowData = reinterpret_cast<const FCityObjectData*>(Row.Value);
+
+		Rows.Add(Row.Key, RowData);
+
+		// first row in table order wins, as the chain walk did before
+		if (!RowData->NextLevelObjectName.IsNone() && !PreviousLevels.Contains(RowData->NextLevelObjectName))
+		{
+			PreviousLevels.Add(RowData->NextLevelObjectName, Row.Key);
+		}
+
+		if (RowData->FitForQuest)
+		{
+			QuestObjects.Add(Row.Key);
+		}
+
+		GeneratorFamilies.FindOrAdd(Row.Key).AddUnique(Row.Key);
+
+		const FString ObjectName = Row.Key.ToString();
+		if (ObjectName.Len() > 1 && (ObjectName.EndsWith("2") || ObjectName.EndsWith("3")))
+		{
+			GeneratorFamilies.FindOrAdd(FName(ObjectName.LeftChop(1))).AddUnique(Row.Key);
+		}
+	}
+
+	for (const auto& Row : Rows)
+	{
+		FName Root = Row.Key;
+
+		// broken tables can have cycles, chain can't be longer than the table
+		for (int32 Step = 0; Step < Rows.Num(); Step++)
+		{
+			const FName* Previous = PreviousLevels.Find(Root);
+
+			if (!Previous)
+				break;
+
+			Root = *Previous;
+		}
+
+		ChainRoots.Add(Row.Key, Root);
+	}
+}
+
+const FCityObjectData* FCityObjectsIndex::FindRow(const FName& ObjectName) const
+{
+	const FCityObjectData* const* Row = Rows.Find(ObjectName);
+
+	return Row ? *Row : nullptr;
+}
+
+FName FCityObjectsIndex::GetPreviousLevel(const FName& ObjectName) const
+{
+	const FName* Previous = PreviousLevels.Find(ObjectName);
+
+	return Previous ? *Previous : NAME_None;
+}
+
+FName FCityObjectsIndex::GetChainRoot(const FName& ObjectName) const
+{
+	const FName* Root = ChainRoots.Find(ObjectName);
+
+	return Root ? *Root : ObjectName;
+}
+
+const TArray<FName>& FCityObjectsIndex::GetGeneratorFamily(const FName& GeneratorName) const
+{
+	static const TArray<FName> EmptyFamily;
+
+	const TArray<FName>* Family = GeneratorFamilies.Find(GeneratorName);
+
+	return Family ? *Family : EmptyFamily;
+}
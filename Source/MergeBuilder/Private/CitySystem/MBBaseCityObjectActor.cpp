@@ -2,8 +2,7 @@
 
 
 #include "CitySystem/MBBaseCityObjectActor.h"
-#include "CitySystem/MBBaseGroundTileActor.h"
-#include "Kismet/GameplayStatics.h"
+#include "CitySystem/MBCityBuilderManager.h"
 
 // Sets default values
 AMBBaseCityObjectActor::AMBBaseCityObjectActor()
@@ -40,13 +39,15 @@ void AMBBaseCityObjectActor::Tick(float DeltaTime)
 
 ECityObjectLocationState AMBBaseCityObjectActor::CheckLocation()
 {
-	TArray<AActor*> OverlappingCityObjects;
-	GetOverlappingActors(OverlappingCityObjects, AMBBaseCityObjectActor::StaticClass());
+	check(CityManager);
 
-	TArray<AActor*> OverlappingGroundTiles;
-	GetOverlappingActors(OverlappingGroundTiles, AMBBaseGroundTileActor::StaticClass());
+	FMBCityFootprint Footprint;
+	GetFootprint(Footprint);
 
-	if (OverlappingCityObjects.Num() == 0 && OverlappingGroundTiles.Num() != 0)
+	TArray<AMBBaseCityObjectActor*> OverlappingCityObjects;
+	CityManager->GetOverlappingCityObjects(this, Footprint, OverlappingCityObjects);
+
+	if (OverlappingCityObjects.Num() == 0 && CityManager->IsOnGround(Footprint))
 		return ECityObjectLocationState::Acceptable;
 
 	if (CityObjectData.ObjectID == INDEX_NONE)
@@ -57,7 +58,7 @@ ECityObjectLocationState AMBBaseCityObjectActor::CheckLocation()
 		if (Actor->GetClass() == GetClass())
 		{
 			auto CityBuilderSubsystem = GetGameInstance()->GetSubsystem<UCityBuilderSubsystem>();
-			const FCityObjectData* RowStruct = CityBuilderSubsystem->CityObjectsDataTable->FindRow<FCityObjectData>(CityObjectData.ObjectName, "");
+			const FCityObjectData* RowStruct = CityBuilderSubsystem->GetObjectsIndex().FindRow(CityObjectData.ObjectName);
 
 			if (!RowStruct->NextLevelObjectName.IsNone())
 			{
@@ -74,85 +75,93 @@ void AMBBaseCityObjectActor::TrySnapToClosestObject()
 	if (!CanSnap)
 		return;
 	
-	TArray<AActor*> CityObjects;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), AMBBaseCityObjectActor::StaticClass(), CityObjects);
+	check(CityManager);
+
+	TArray<FVector> SelfSnapSockets;
+	GetSnapSockets(SelfSnapSockets);
+
+	if (SelfSnapSockets.Num() == 0)
+		return;
 
 	float MaxDistanceToCheck = 3000.0f;
-	TArray<AActor*> ClosestObjects;
-	for (AActor* Object : CityObjects)
+
+	const FVector2D Location = FVector2D(GetActorLocation());
+	const FVector2D CheckExtent = FVector2D(MaxDistanceToCheck, MaxDistanceToCheck);
+	const FBox2D CheckArea = FBox2D(Location - CheckExtent, Location + CheckExtent);
+
+	TArray<AMBBaseCityObjectActor*> CityObjects;
+	CityManager->CityGrid.Query(CheckArea, CityObjects);
+
+	// closest snap delta distance
+	FVector ClosestSnapDelta = FVector::ZeroVector;
+	float ClosestSnapDistSquared = MAX_flt;
+	int32 ClosestObjectID = MAX_int32;
+
+	for (auto CityObject : CityObjects)
 	{
-		if (Object == this)
+		if (CityObject == this || !IsValid(CityObject))
 			continue;
-		float Distance = FVector::Dist(Object->GetActorLocation(), GetActorLocation());
 
-		if (Distance > MaxDistanceToCheck)
+		if (FVector::DistSquared(CityObject->GetActorLocation(), GetActorLocation()) > FMath::Square(MaxDistanceToCheck))
 			continue;
-		
-		auto CityObject = Cast<AMBBaseCityObjectActor>(Object);
 
 		if (!CityObject->CanSnap)
 			continue;
-		
-		ClosestObjects.Add(Object);
-	}
 
-	if (ClosestObjects.Num() == 0)
-		return;
-
-	TArray<UActorComponent*> SceneComponents;
-	for (auto Object : ClosestObjects)
-	{
-		TArray<UActorComponent*> Components;
-		Object->GetComponents(USceneComponent::StaticClass(), Components, true);
+		// sockets of placed objects are cached in world space when they are accepted
+		const TArray<FVector>* OtherSnapSockets = CityManager->CityGrid.FindSnapSockets(CityObject);
 
-		SceneComponents.Insert(Components, SceneComponents.Num());
-	}
+		if (!OtherSnapSockets)
+			continue;
 
-	TArray<USceneComponent*> OtherSnapComponents;
-	for (UActorComponent* SceneComponent : SceneComponents)
-	{
-		if (USceneComponent* SnapComponent = Cast<USceneComponent>(SceneComponent))
+		for (const FVector& SelfSnapSocket : SelfSnapSockets)
 		{
-			if (SnapComponent->ComponentHasTag("Snap"))
-				OtherSnapComponents.Add(SnapComponent);
+			for (const FVector& OtherSnapSocket : *OtherSnapSockets)
+			{
+				FVector CurDelta = OtherSnapSocket - SelfSnapSocket;
+				const float CurDistSquared = CurDelta.SizeSquared();
+
+				// grid order depends on placement history, equal distances go to the object with lower id
+				const bool IsTie = CurDistSquared == ClosestSnapDistSquared && CityObject->CityObjectData.ObjectID < ClosestObjectID;
+
+				if (CurDistSquared < ClosestSnapDistSquared || IsTie)
+				{
+					ClosestSnapDelta = CurDelta;
+					ClosestSnapDistSquared = CurDistSquared;
+					ClosestObjectID = CityObject->CityObjectData.ObjectID;
+				}
+			}
 		}
 	}
 
-	if (OtherSnapComponents.Num() == 0)
+	if (ClosestSnapDistSquared == MAX_flt)
 		return;
 
-	SceneComponents.Empty();
-	GetComponents(USceneComponent::StaticClass(), SceneComponents, true);
-	
-	TArray<USceneComponent*> SelfSnapComponents;
-	for (UActorComponent* SceneComponent : SceneComponents)
-	{
-		if (USceneComponent* SnapComponent = Cast<USceneComponent>(SceneComponent))
-		{
-			if (SnapComponent->ComponentHasTag("Snap"))
-				SelfSnapComponents.Add(SnapComponent);
-		}
-	}
+	AddActorWorldOffset(ClosestSnapDelta);
 
-	if (SelfSnapComponents.Num() == 0)
-		return;
+	SetEditMaterial(CheckLocation());
+}
 
-	// closest snap delta distance
-	FVector ClosestSnapDelta = FVector(FLT_MAX);
+void AMBBaseCityObjectActor::GetSnapSockets(TArray<FVector>& OutSockets) const
+{
+	check(CityManager);
 
-	for (USceneComponent* SelfSnapComponent : SelfSnapComponents)
-	{
-		for (USceneComponent* OtherSnapComponent : OtherSnapComponents)
-		{
-			FVector CurDelta = OtherSnapComponent->GetComponentLocation() - SelfSnapComponent->GetComponentLocation();
+	const FTransform& ActorTransform = GetActorTransform();
 
-			if (CurDelta.Size() < ClosestSnapDelta.Size())
-				ClosestSnapDelta = CurDelta;
-		}
+	for (const FVector& LocalSocket : CityManager->GetClassSnapSockets(this))
+	{
+		OutSockets.Add(ActorTransform.TransformPosition(LocalSocket));
 	}
+}
 
-	AddActorWorldOffset(ClosestSnapDelta);
+void AMBBaseCityObjectActor::GetFootprint(FMBCityFootprint& OutFootprint) const
+{
+	// local bounds don't include actor scale and rotation
+	const FBox LocalBounds = CalculateComponentsBoundingBoxInLocalSpace(false);
+	const FTransform& ActorTransform = GetActorTransform();
 
-	SetEditMaterial(CheckLocation());
+	OutFootprint.Center = FVector2D(ActorTransform.TransformPosition(LocalBounds.GetCenter()));
+	OutFootprint.Extent = FVector2D(LocalBounds.GetExtent() * ActorTransform.GetScale3D());
+	OutFootprint.Yaw = GetActorRotation().Yaw;
 }
 
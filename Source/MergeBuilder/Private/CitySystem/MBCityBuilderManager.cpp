@@ -4,8 +4,8 @@
 #include "CitySystem/MBCityBuilderManager.h"
 #include "CitySystem/CityBuilderSubsystem.h"
 #include "CitySystem/MBBaseCityObjectActor.h"
+#include "CitySystem/MBGroundSubsystem.h"
 #include "TopDownPawn.h"
-#include "Kismet/GameplayStatics.h"
 
 // Sets default values
 AMBCityBuilderManager::AMBCityBuilderManager()
@@ -19,6 +19,8 @@ AMBCityBuilderManager::AMBCityBuilderManager()
 void AMBCityBuilderManager::BeginPlay()
 {
 	Super::BeginPlay();
+
+	CityGrid.Init(CityGridCellSize);
 	
 	InitializeCity();
 
@@ -36,7 +38,7 @@ void AMBCityBuilderManager::InitializeCity()
 
 	for (const auto& Object : CityObjects)
 	{
-		const FCityObjectData* RowStruct = CityBuilderSubsystem->CityObjectsDataTable->FindRow<FCityObjectData>(Object.ObjectName, "AMBCityBuilderManager::InitializeCity()");
+		const FCityObjectData* RowStruct = CityBuilderSubsystem->GetObjectsIndex().FindRow(Object.ObjectName);
 
 		if (!RowStruct)
 		{
@@ -55,7 +57,11 @@ void AMBCityBuilderManager::InitializeCity()
 
 		auto SpawnedObject = GetWorld()->SpawnActor<AMBBaseCityObjectActor>(ObjectActorClass, SpawnTransform);
 
+		SpawnedObject->CityManager = this;
 		SpawnedObject->Initialize(Object, RowStruct);
+
+		CityObjectActors.Add(Object.ObjectID, SpawnedObject);
+		AddToCityGrid(SpawnedObject);
 	}
 }
 
@@ -63,7 +69,7 @@ AMBBaseCityObjectActor* AMBCityBuilderManager::SpawnNewObject(const FName& Objec
 {
 	auto CityBuilderSubsystem = GetGameInstance()->GetSubsystem<UCityBuilderSubsystem>();
 
-	const FCityObjectData* RowStruct = CityBuilderSubsystem->CityObjectsDataTable->FindRow<FCityObjectData>(ObjectName, "AMBCityBuilderManager::SpawnNewObject()");
+	const FCityObjectData* RowStruct = CityBuilderSubsystem->GetObjectsIndex().FindRow(ObjectName);
 
 	if (!RowStruct)
 	{
@@ -84,6 +90,7 @@ AMBBaseCityObjectActor* AMBCityBuilderManager::SpawnNewObject(const FName& Objec
 	ObjectStruct.ObjectName = ObjectName;
 	ObjectStruct.Location = SpawnLocation;
 
+	SpawnedObject->CityManager = this;
 	SpawnedObject->Initialize(ObjectStruct, RowStruct);
 
 	SetEditedObject(SpawnedObject);
@@ -132,12 +139,16 @@ void AMBCityBuilderManager::AcceptEditObject()
 	{
 		CityBuilderSubsystem->SpendResourcesForBuildObject(EditedObject->CityObjectData.ObjectName);
 		CityBuilderSubsystem->AddNewObject(EditedObject->CityObjectData);
+
+		CityObjectActors.Add(EditedObject->CityObjectData.ObjectID, EditedObject);
 	}
 	else
 	{
 		CityBuilderSubsystem->EditObject(EditedObject->CityObjectData);
 	}
 
+	AddToCityGrid(EditedObject);
+
 	if (MergedObject1)
 	{
 		RemoveCityObject(MergedObject1);
@@ -161,13 +172,17 @@ void AMBCityBuilderManager::RemoveCityObject(AMBBaseCityObjectActor* ObjectToRem
 	auto CityBuilderSubsystem = GetGameInstance()->GetSubsystem<UCityBuilderSubsystem>();
 	CityBuilderSubsystem->RemoveObject(ObjectToRemove->CityObjectData);
 
+	CityGrid.Remove(ObjectToRemove);
+	CityObjectActors.Remove(ObjectToRemove->CityObjectData.ObjectID);
+
 	ObjectToRemove->Destroy();
 }
 
 void AMBCityBuilderManager::CollectRewardFromCityObject(AMBBaseCityObjectActor* CityObject)
 {
 	auto CityBuilderSubsystem = GetGameInstance()->GetSubsystem<UCityBuilderSubsystem>();
-	CityBuilderSubsystem->CollectFromObject(CityObject->CityObjectData);
+	if (!CityBuilderSubsystem->CollectFromObject(CityObject->CityObjectData))
+		return;
 
 	CityBuilderSubsystem->SaveCity();
 }
@@ -178,7 +193,7 @@ void AMBCityBuilderManager::MergeObjects(AMBBaseCityObjectActor* Object1, AMBBas
 	check(Object2);
 	
 	auto CityBuilderSubsystem = GetGameInstance()->GetSubsystem<UCityBuilderSubsystem>();
-	const FCityObjectData* RowStruct = CityBuilderSubsystem->CityObjectsDataTable->FindRow<FCityObjectData>(Object1->CityObjectData.ObjectName, "");
+	const FCityObjectData* RowStruct = CityBuilderSubsystem->GetObjectsIndex().FindRow(Object1->CityObjectData.ObjectName);
 
 	FName NextLevelObjectName = RowStruct->NextLevelObjectName;
 
@@ -197,14 +212,11 @@ void AMBCityBuilderManager::MergeObjects(AMBBaseCityObjectActor* Object1, AMBBas
 
 void AMBCityBuilderManager::UpdateQuestsForObjects(TArray<int32> ObjectIDs)
 {
-	TArray<AActor*> ObjectsToUpdate;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), AMBBaseCityObjectActor::StaticClass(), ObjectsToUpdate);
-
-	for (auto Actor : ObjectsToUpdate)
+	for (int32 ObjectID : ObjectIDs)
 	{
-		AMBBaseCityObjectActor* CityObject = Cast<AMBBaseCityObjectActor>(Actor);
+		AMBBaseCityObjectActor* CityObject = GetCityObjectActor(ObjectID);
 
-		if (!ObjectIDs.Contains(CityObject->CityObjectData.ObjectID))
+		if (!CityObject)
 		{
 			continue;
 		}
@@ -230,15 +242,18 @@ void AMBCityBuilderManager::HandleDragRelease()
 	ECityObjectLocationState State = EditedObject->CheckLocation();
 	if (State == ECityObjectLocationState::MergeReady)
 	{
-		TArray<AActor*> OverlappingActors;
-		EditedObject->GetOverlappingActors(OverlappingActors, AMBBaseCityObjectActor::StaticClass());
+		FMBCityFootprint Footprint;
+		EditedObject->GetFootprint(Footprint);
+
+		TArray<AMBBaseCityObjectActor*> OverlappingObjects;
+		GetOverlappingCityObjects(EditedObject, Footprint, OverlappingObjects);
 
 		AMBBaseCityObjectActor* ObjectToMerge = nullptr;
-		for (auto Actor : OverlappingActors)
+		for (auto CityObject : OverlappingObjects)
 		{
-			if (Actor->GetClass() == EditedObject->GetClass())
+			if (CityObject->GetClass() == EditedObject->GetClass())
 			{
-				ObjectToMerge = Cast<AMBBaseCityObjectActor>(Actor);
+				ObjectToMerge = CityObject;
 				break;
 			}
 		}
@@ -320,4 +335,104 @@ void AMBCityBuilderManager::CancelEditionObject()
 void AMBCityBuilderManager::HandleObjectClick(AMBBaseCityObjectActor* CityObject)
 {
 	OnObjectClicked.Broadcast(CityObject);
-}
\ No newline at end of file
+}
+
+AMBBaseCityObjectActor* AMBCityBuilderManager::GetCityObjectActor(int32 ObjectID) const
+{
+	AMBBaseCityObjectActor* const* CityObject = CityObjectActors.Find(ObjectID);
+
+	return CityObject ? *CityObject : nullptr;
+}
+
+void AMBCityBuilderManager::GetOverlappingCityObjects(const AMBBaseCityObjectActor* Object, const FMBCityFootprint& Footprint, TArray<AMBBaseCityObjectActor*>& OutObjects) const
+{
+	TArray<AMBBaseCityObjectActor*> NearObjects;
+	CityGrid.Query(Footprint.GetBounds(), NearObjects);
+
+	for (auto NearObject : NearObjects)
+	{
+		if (NearObject == Object || !IsValid(NearObject))
+			continue;
+
+		// merged objects are hidden until merge is accepted or canceled
+		if (!NearObject->GetActorEnableCollision())
+			continue;
+
+		const FMBCityFootprint* NearFootprint = CityGrid.FindFootprint(NearObject);
+
+		if (NearFootprint && Footprint.Intersects(*NearFootprint))
+		{
+			OutObjects.Add(NearObject);
+		}
+	}
+}
+
+bool AMBCityBuilderManager::IsOnGround(const FMBCityFootprint& Footprint)
+{
+	auto GroundSubsystem = GetGameInstance()->GetSubsystem<UMBGroundSubsystem>();
+
+	const FBox2D Bounds = Footprint.GetBounds();
+	const FIntPoint MinIndex = GroundSubsystem->GetTileIndexForLocation(Bounds.Min);
+	const FIntPoint MaxIndex = GroundSubsystem->GetTileIndexForLocation(Bounds.Max);
+
+	for (int32 Y = MinIndex.Y; Y <= MaxIndex.Y; Y++)
+	{
+		for (int32 X = MinIndex.X; X <= MaxIndex.X; X++)
+		{
+			const FIntPoint Index = FIntPoint(X, Y);
+
+			FMBGroundTile Tile;
+			if (!GroundSubsystem->GetGroundTile(Index, Tile))
+				continue;
+
+			FMBCityFootprint TileFootprint;
+			TileFootprint.Center = GroundSubsystem->GetTileCenter(Index);
+			TileFootprint.Extent = FVector2D(GroundTileSize / 2.0f, GroundTileSize / 2.0f);
+
+			if (Footprint.Intersects(TileFootprint))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+const TArray<FVector>& AMBCityBuilderManager::GetClassSnapSockets(const AMBBaseCityObjectActor* Object)
+{
+	if (const TArray<FVector>* Sockets = ClassSnapSockets.Find(Object->GetClass()))
+		return *Sockets;
+
+	TArray<FVector>& Sockets = ClassSnapSockets.Add(Object->GetClass());
+
+	if (!Object->CanSnap)
+		return Sockets;
+
+	TArray<USceneComponent*> SceneComponents;
+	Object->GetComponents<USceneComponent>(SceneComponents, true);
+
+	const FTransform& ActorTransform = Object->GetActorTransform();
+
+	for (USceneComponent* SceneComponent : SceneComponents)
+	{
+		if (SceneComponent->ComponentHasTag("Snap"))
+		{
+			Sockets.Add(ActorTransform.InverseTransformPosition(SceneComponent->GetComponentLocation()));
+		}
+	}
+
+	return Sockets;
+}
+
+void AMBCityBuilderManager::AddToCityGrid(AMBBaseCityObjectActor* Object)
+{
+	FMBCityFootprint Footprint;
+	Object->GetFootprint(Footprint);
+
+	TArray<FVector> SnapSockets;
+	if (Object->CanSnap)
+	{
+		Object->GetSnapSockets(SnapSockets);
+	}
+
+	CityGrid.Add(Object, Footprint, MoveTemp(SnapSockets));
+}
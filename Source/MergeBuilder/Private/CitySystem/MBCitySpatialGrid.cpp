@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CitySystem/MBCitySpatialGrid.h"
+
+namespace
+{
+	// gap allowed between snapped objects without overlap
+	constexpr float FootprintTolerance = 1.0f;
+}
+
+FBox2D FMBCityFootprint::GetBounds() const
+{
+	const FVector2D HalfSize = FVector2D(GetProjectedRadius(FVector2D(1.0f, 0.0f)), GetProjectedRadius(FVector2D(0.0f, 1.0f)));
+
+	return FBox2D(Center - HalfSize, Center + HalfSize);
+}
+
+bool FMBCityFootprint::Intersects(const FMBCityFootprint& Other) const
+{
+	FVector2D Axes[4];
+	GetAxes(Axes[0], Axes[1]);
+	Other.GetAxes(Axes[2], Axes[3]);
+
+	const FVector2D Delta = Other.Center - Center;
+
+	// boxes intersect if there is no separating axis among their edges
+	for (const FVector2D& Axis : Axes)
+	{
+		const float Distance = FMath::Abs(Delta | Axis);
+		const float Radius = GetProjectedRadius(Axis) + Other.GetProjectedRadius(Axis);
+
+		if (Distance >= Radius - FootprintTolerance)
+			return false;
+	}
+
+	return true;
+}
+
+void FMBCityFootprint::GetAxes(FVector2D& OutAxisX, FVector2D& OutAxisY) const
+{
+	float Sin, Cos;
+	FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(Yaw));
+
+	OutAxisX = FVector2D(Cos, Sin);
+	OutAxisY = FVector2D(-Sin, Cos);
+}
+
+float FMBCityFootprint::GetProjectedRadius(const FVector2D& Axis) const
+{
+	FVector2D AxisX, AxisY;
+	GetAxes(AxisX, AxisY);
+
+	return Extent.X * FMath::Abs(AxisX | Axis) + Extent.Y * FMath::Abs(AxisY | Axis);
+}
+
+void FMBCitySpatialGrid::Init(float InCellSize)
+{
+	check(InCellSize > 0.0f);
+
+	CellSize = InCellSize;
+	Cells.Empty();
+	Entries.Empty();
+}
+
+void FMBCitySpatialGrid::Add(AMBBaseCityObjectActor* Object, const FMBCityFootprint& Footprint, TArray<FVector>&& SnapSockets)
+{
+	Remove(Object);
+
+	FEntry& Entry = Entries.Add(Object);
+	Entry.Footprint = Footprint;
+	Entry.SnapSockets = MoveTemp(SnapSockets);
+
+	FIntPoint MinCell, MaxCell;
+	GetCellRange(Footprint.GetBounds(), MinCell, MaxCell);
+
+	for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+	{
+		for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+		{
+			Cells.FindOrAdd(FIntPoint(X, Y)).Add(Object);
+		}
+	}
+}
+
+void FMBCitySpatialGrid::Remove(AMBBaseCityObjectActor* Object)
+{
+	const FEntry* Entry = Entries.Find(Object);
+	if (!Entry)
+		return;
+
+	FIntPoint MinCell, MaxCell;
+	GetCellRange(Entry->Footprint.GetBounds(), MinCell, MaxCell);
+
+	Entries.Remove(Object);
+
+	for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+	{
+		for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+		{
+			const FIntPoint Cell = FIntPoint(X, Y);
+			TArray<AMBBaseCityObjectActor*>* CellObjects = Cells.Find(Cell);
+
+			if (!CellObjects)
+				continue;
+
+			CellObjects->RemoveSingleSwap(Object);
+
+			if (CellObjects->Num() == 0)
+			{
+				Cells.Remove(Cell);
+			}
+		}
+	}
+}
+
+void FMBCitySpatialGrid::Query(const FBox2D& Area, TArray<AMBBaseCityObjectActor*>& OutObjects) const
+{
+	FIntPoint MinCell, MaxCell;
+	GetCellRange(Area, MinCell, MaxCell);
+
+	for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+	{
+		for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+		{
+			const TArray<AMBBaseCityObjectActor*>* CellObjects = Cells.Find(FIntPoint(X, Y));
+
+			if (!CellObjects)
+				continue;
+
+			for (auto Object : *CellObjects)
+			{
+				// large objects are stored in several cells
+				OutObjects.AddUnique(Object);
+			}
+		}
+	}
+}
+
+const FMBCityFootprint* FMBCitySpatialGrid::FindFootprint(const AMBBaseCityObjectActor* Object) const
+{
+	const FEntry* Entry = Entries.Find(Object);
+
+	return Entry ? &Entry->Footprint : nullptr;
+}
+
+const TArray<FVector>* FMBCitySpatialGrid::FindSnapSockets(const AMBBaseCityObjectActor* Object) const
+{
+	const FEntry* Entry = Entries.Find(Object);
+
+	return Entry ? &Entry->SnapSockets : nullptr;
+}
+
+void FMBCitySpatialGrid::GetCellRange(const FBox2D& Area, FIntPoint& OutMinCell, FIntPoint& OutMaxCell) const
+{
+	OutMinCell = FIntPoint(FMath::FloorToInt(Area.Min.X / CellSize), FMath::FloorToInt(Area.Min.Y / CellSize));
+	OutMaxCell = FIntPoint(FMath::FloorToInt(Area.Max.X / CellSize), FMath::FloorToInt(Area.Max.Y / CellSize));
+}
@@ -4,7 +4,6 @@
 #include "CitySystem/MBGroundFieldManager.h"
 
 #include "Analytics/FGAnalytics.h"
-#include "Kismet/GameplayStatics.h"
 #include "User/AccountSubsystem.h"
 
 // Sets default values
@@ -43,10 +42,7 @@ void AMBGroundFieldManager::GetTileLocationForIndex(const FIntPoint& Index, FVec
 {
 	auto GroundFieldSubsystem = GetGameInstance()->GetSubsystem<UMBGroundSubsystem>();
 	
-	Location.Z = 100.0f;
-
-	Location.X = (Index.X - GroundFieldSubsystem->GetFieldSize().X / 2.0f) * 3000.0f;
-	Location.Y = (Index.Y - GroundFieldSubsystem->GetFieldSize().Y / 2.0f) * 3000.0f;
+	Location = FVector(GroundFieldSubsystem->GetTileCenter(Index), 100.0f);
 }
 
 void AMBGroundFieldManager::GetTileRotation(const FIntPoint& Index, const TArray<FMBGroundTile>& Neighbors,
@@ -187,18 +183,22 @@ void AMBGroundFieldManager::SpawnAllPossibleGroundTiles()
 		auto PossibleTileActor = GetWorld()->SpawnActor<AMBPossibleGroundActor>(PossibleGroundTileClass, Transform);
 		
 		PossibleTileActor->Init(GroundTile.Index);
+
+		PossibleTileActors.Add(PossibleTileActor);
 	}
 }
 
 void AMBGroundFieldManager::RemoveAllPossibleGroundTiles()
 {
-	TArray<AActor*> PossibleGroundTiles;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), AMBPossibleGroundActor::StaticClass(), PossibleGroundTiles);
-
-	for (auto& PossibleTile : PossibleGroundTiles)
+	for (auto PossibleTile : PossibleTileActors)
 	{
-		PossibleTile->Destroy();
+		if (IsValid(PossibleTile))
+		{
+			PossibleTile->Destroy();
+		}
 	}
+
+	PossibleTileActors.Empty();
 }
 
 AMBBaseGroundTileActor* AMBGroundFieldManager::SpawnGroundTile(const FMBGroundTile& GroundTile)
@@ -224,25 +224,16 @@ AMBBaseGroundTileActor* AMBGroundFieldManager::SpawnGroundTile(const FMBGroundTi
 	GroundTileActor->InitMeshByType(Type);
 	GroundTileActor->SetIndex(GroundTile.Index);
 
+	TileActors.Add(GroundTile.Index, GroundTileActor);
+
 	return GroundTileActor;
 }
 
 AMBBaseGroundTileActor* AMBGroundFieldManager::GetTileActorByIndex(const FIntPoint& Index)
 {
-	TArray<AActor*> Actors;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), AMBBaseGroundTileActor::StaticClass(), Actors);
-
-	for (auto& Actor : Actors)
-	{
-		auto Tile = Cast<AMBBaseGroundTileActor>(Actor);
-
-		if (Tile && Tile->GetIndex() == Index)
-		{
-			return Tile;
-		}
-	}
+	AMBBaseGroundTileActor** Tile = TileActors.Find(Index);
 
-	return nullptr;
+	return Tile ? *Tile : nullptr;
 }
 
 void AMBGroundFieldManager::BuyGroundTile(const FIntPoint& Index)
@@ -3,7 +3,7 @@
 
 #include "CitySystem/MBGroundSubsystem.h"
 
-#include "JsonObjectConverter.h"
+#include "Utilities/MBJsonCodec.h"
 #include "MBUtilityFunctionLibrary.h"
 
 UMBGroundSubsystem::UMBGroundSubsystem()
@@ -37,34 +37,76 @@ void UMBGroundSubsystem::Deinitialize()
 
 void UMBGroundSubsystem::SaveGround()
 {
-	TSharedPtr<FJsonObject> JsonObject = MakeShared<FJsonObject>();
+	UMBUtilityFunctionLibrary::SaveBinaryToStorage("GroundField", GroundStorageVersion, [this](FArchive& Ar, int32 Version)
+	{
+		SerializeGround(Ar, Version);
+	});
+
+	if (UMBUtilityFunctionLibrary::IsJsonExportEnabled())
+	{
+		ExportGroundJson();
+	}
+}
+
+void UMBGroundSubsystem::SerializeGround(FArchive& Ar, int32 Version)
+{
+	// indexes of not void tiles
+	TArray<FIntPoint> TileIndexes;
+
+	if (Ar.IsSaving())
+	{
+		for (const auto& Row : GroundField)
+		{
+			for (const auto& Tile : Row)
+			{
+				if (!Tile.IsVoid)
+					TileIndexes.Add(Tile.Index);
+			}
+		}
+	}
 
-	TSharedPtr<FJsonObject> FieldObject = MakeShared<FJsonObject>();
+	Ar << TileIndexes;
+
+	if (Ar.IsLoading())
+	{
+		for (const auto& Index : TileIndexes)
+		{
+			if (!GroundField.IsValidIndex(Index.Y) || !GroundField[Index.Y].IsValidIndex(Index.X))
+				continue;
+
+			GroundField[Index.Y][Index.X].IsVoid = false;
+			GroundField[Index.Y][Index.X].Index = Index;
+		}
+	}
+}
+
+void UMBGroundSubsystem::ExportGroundJson()
+{
+	FString StringData;
+	auto Writer = FMBJsonCodec::CreateWriter(StringData);
+
+	Writer->WriteObjectStart();
+	Writer->WriteObjectStart("field");
 
 	for (int32 i = -GroundFieldSize.Y/2; i < GroundFieldSize.Y/2; i++)
 	{
-		TSharedPtr<FJsonObject> RowObject = MakeShared<FJsonObject>();
+		Writer->WriteObjectStart(FString::FromInt(i));
 
 		for (int32 j = -GroundFieldSize.X/2; j < GroundFieldSize.X/2; j++)
 		{
-			FMBGroundTile Tile = GroundField[i + GroundFieldSize.Y/2][j + GroundFieldSize.X/2];
+			const FMBGroundTile& Tile = GroundField[i + GroundFieldSize.Y/2][j + GroundFieldSize.X/2];
 			if (Tile.IsVoid)
 				continue;
 
-			TSharedPtr<FJsonObject> ItemObject;
-
-			ItemObject = FJsonObjectConverter::UStructToJsonObject<FMBGroundTile>(Tile);
-
-			RowObject->SetObjectField(FString::FromInt(j), ItemObject);
+			FMBJsonCodec::WriteStruct(*Writer, FString::FromInt(j), Tile);
 		}
 
-		FieldObject->SetObjectField(FString::FromInt(i), RowObject);
+		Writer->WriteObjectEnd();
 	}
 
-	JsonObject->SetObjectField("field", FieldObject);
-
-	FString StringData;
-	UMBUtilityFunctionLibrary::JsonObjectToString(JsonObject, StringData);
+	Writer->WriteObjectEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
 
 	UMBUtilityFunctionLibrary::SaveToStorage("GroundField", StringData);
 }
@@ -149,6 +191,17 @@ bool UMBGroundSubsystem::GetGroundTile(const FIntPoint& Index, FMBGroundTile& Ou
 	return !OutGroundTile.IsVoid;
 }
 
+FVector2D UMBGroundSubsystem::GetTileCenter(const FIntPoint& Index) const
+{
+	return FVector2D(Index.X - GroundFieldSize.X / 2.0f, Index.Y - GroundFieldSize.Y / 2.0f) * GroundTileSize;
+}
+
+FIntPoint UMBGroundSubsystem::GetTileIndexForLocation(const FVector2D& Location) const
+{
+	// tile covers half of its size around the center
+	return FIntPoint(FMath::RoundToInt(Location.X / GroundTileSize + GroundFieldSize.X / 2.0f), FMath::RoundToInt(Location.Y / GroundTileSize + GroundFieldSize.Y / 2.0f));
+}
+
 void UMBGroundSubsystem::GetGroundTileInfo(const FIntPoint& Index, FMBPossibleGroundTileInfo& OutGroundTileInfo)
 {
 	FName RowName = FName(FString::FromInt(Index.X) + "_" + FString::FromInt(Index.Y));
@@ -196,10 +249,10 @@ void UMBGroundSubsystem::CalculateBoundingSquare()
 	}
 
 	MaxBoundingLocation = FVector(Max.X + 1, Max.Y + 1, 0);
-	MaxBoundingLocation *= 3000.0f;
+	MaxBoundingLocation *= GroundTileSize;
 
 	MinBoundingLocation = FVector(Min.X - 1, Min.Y - 1, 0);
-	MinBoundingLocation *= 3000.0f;
+	MinBoundingLocation *= GroundTileSize;
 }
 
 void UMBGroundSubsystem::InitGroundField()
@@ -218,10 +271,20 @@ void UMBGroundSubsystem::InitGroundField()
 		}
 	}
 	
+	const bool BinaryLoaded = UMBUtilityFunctionLibrary::ReadBinaryFromStorage("GroundField", [this](FArchive& Ar, int32 Version)
+	{
+		SerializeGround(Ar, Version);
+	});
+
+	if (BinaryLoaded)
+		return;
+
 	FString SavedData;
 	if (UMBUtilityFunctionLibrary::ReadFromStorage("GroundField", SavedData))
 	{
+		// migrate ground from json storage
 		ParseGround(SavedData);
+		SaveGround();
 	}
 	else
 	{
@@ -249,31 +312,49 @@ void UMBGroundSubsystem::InitStartGroundField()
 
 void UMBGroundSubsystem::ParseGround(const FString& JsonString)
 {
-	TSharedPtr<FJsonObject> JsonObject;
-	
-	if (!UMBUtilityFunctionLibrary::StringToJsonObject(JsonString, JsonObject))
-		return;
+	auto Reader = FMBJsonCodec::CreateReader(JsonString);
 
-	const TSharedPtr<FJsonObject>* FieldObject;
+	EJsonNotation Notation;
+	if (!Reader->ReadNext(Notation) || Notation != EJsonNotation::ObjectStart)
+		return;
 
-	if (JsonObject.Get()->TryGetObjectField("field", FieldObject))
+	while (Reader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
 	{
-		for (int32 i = -GroundFieldSize.Y/2; i < GroundFieldSize.Y/2; i++)
+		if (Reader->GetIdentifier() != "field" || Notation != EJsonNotation::ObjectStart)
+		{
+			FMBJsonCodec::SkipValue(*Reader, Notation);
+			continue;
+		}
+
+		// rows and tiles are keyed by their index relative to the field center
+		while (Reader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
 		{
-			const TSharedPtr<FJsonObject>* RowObject;
-			if (!FieldObject->Get()->TryGetObjectField(FString::FromInt(i), RowObject))
+			if (Notation != EJsonNotation::ObjectStart)
+			{
+				FMBJsonCodec::SkipValue(*Reader, Notation);
 				continue;
+			}
+
+			const int32 i = FCString::Atoi(*Reader->GetIdentifier());
 
-			for (int32 j = -GroundFieldSize.X/2; j < GroundFieldSize.X/2; j++)
+			while (Reader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
 			{
-				const TSharedPtr<FJsonObject>* ItemObject;
-				if (!RowObject->Get()->TryGetObjectField(FString::FromInt(j), ItemObject))
+				if (Notation != EJsonNotation::ObjectStart)
+				{
+					FMBJsonCodec::SkipValue(*Reader, Notation);
 					continue;
+				}
+
+				const int32 j = FCString::Atoi(*Reader->GetIdentifier());
 
 				FMBGroundTile Tile;
-				FJsonObjectConverter::JsonObjectToUStruct<FMBGroundTile>(ItemObject->ToSharedRef(), &Tile);
+				FMBJsonCodec::ReadStruct(*Reader, Tile);
 
 				Tile.Index = FIntPoint(j + GroundFieldSize.X/2, i + GroundFieldSize.Y/2);
+
+				if (Tile.Index.X < 0 || Tile.Index.X >= GroundFieldSize.X || Tile.Index.Y < 0 || Tile.Index.Y >= GroundFieldSize.Y)
+					continue;
+
 				GroundField[Tile.Index.Y][Tile.Index.X] = Tile;
 			}
 		}
@@ -27,6 +27,8 @@ void AMBBasePlayerController::BeginPlay()
 	TopDownPawn = Cast<ATopDownPawn>(UGameplayStatics::GetActorOfClass(GetWorld(), ATopDownPawn::StaticClass()));
 	check(TopDownPawn);
 
+	MergeFieldManager = Cast<AMBMergeFieldManager>(UGameplayStatics::GetActorOfClass(GetWorld(), AMBMergeFieldManager::StaticClass()));
+
 	LoadingScreen = Cast<UUserWidget>(CreateWidget(this, LoadingScreenClass));
 
 #if !WITH_EDITOR
@@ -43,10 +45,9 @@ void AMBBasePlayerController::SwitchToCity()
 {
 	Possess(TopDownPawn);
 
-	auto MergeFieldManager = Cast<AMBMergeFieldManager>(UGameplayStatics::GetActorOfClass(GetWorld(), AMBMergeFieldManager::StaticClass()));
 	if (MergeFieldManager)
 	{
-		MergeFieldManager->DestroyAllItems();
+		MergeFieldManager->SetFieldDormant();
 	}
 }
 
@@ -11,6 +11,9 @@
 #include "CitySystem/CityBuilderSubsystem.h"
 #include "Blueprint/UserWidget.h"
 #include "Kismet/GameplayStatics.h"
+#include "Utilities/MBStorageWriter.h"
+#include "Utilities/MBSaveCoordinator.h"
+#include "Utilities/MBStartupLoader.h"
 
 UMBGameInstance::UMBGameInstance()
 {
@@ -33,6 +36,9 @@ UMBGameInstance::UMBGameInstance()
 
 void UMBGameInstance::Init()
 {
+	// storage is read in parallel while subsystems are created, subsystems take it in their initialization
+	FMBStartupLoader::Get().Start({ "Inventory", "City", "GroundField", "Account", "Quests", "ShopHistory", "TutorialProgress" });
+
 	Super::Init();
 
 	ShopSubsystem->Init();
@@ -79,8 +85,12 @@ void UMBGameInstance::SaveAllData()
 	auto CityBuilderSubsystem = GetSubsystem<UCityBuilderSubsystem>();
 
 	AccountSubsystem->SaveAccount();
-	MergeSubsystem->SaveField();
+	MergeSubsystem->FlushField();
 	CityBuilderSubsystem->SaveCity();
+
+	// app can be killed in background, all data must be on disk
+	FMBSaveCoordinator::Get().Commit();
+	FMBStorageWriter::Get().Flush();
 }
 
 void UMBGameInstance::CheckAllDataLoaded()
@@ -99,10 +109,16 @@ void UMBGameInstance::CheckAllDataLoaded()
 
 	PC->LoadingScreen->RemoveFromParent();
 
+	FMBStartupLoader::Get().MarkInteractive();
+
 	OnGameLoaded.Broadcast();
 }
 
 void UMBGameInstance::Shutdown()
 {
 	Super::Shutdown();
+
+	// subsystems save their data on deinitialize
+	FMBSaveCoordinator::Get().Commit();
+	FMBStorageWriter::Get().Flush();
 }
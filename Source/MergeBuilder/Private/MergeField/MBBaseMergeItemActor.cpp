@@ -2,9 +2,11 @@
 
 
 #include "MergeField/MBBaseMergeItemActor.h"
-#include "Kismet/GameplayStatics.h"
 #include "MergeField/MBMergeFieldManager.h"
 #include "User/AccountSubsystem.h"
+#include "Components/TimelineComponent.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
 
 // Sets default values
 AMBBaseMergeItemActor::AMBBaseMergeItemActor()
@@ -23,7 +25,9 @@ AMBBaseMergeItemActor::AMBBaseMergeItemActor()
 void AMBBaseMergeItemActor::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	SpriteRelativeTransform = Sprite->GetRelativeTransform();
+	SpriteColor = Sprite->GetSpriteColor();
 }
 
 // Called every frame
@@ -32,15 +36,49 @@ void AMBBaseMergeItemActor::Tick(float DeltaTime)
 	Super::Tick(DeltaTime);
 }
 
-void AMBBaseMergeItemActor::Initialize(const FMergeFieldItem& InBaseData, const FMergeItemData& InTableData, const FIntPoint& Index)
+void AMBBaseMergeItemActor::Initialize(const FMergeFieldItem& InBaseData, const FMergeItemData* InTableData, const FIntPoint& Index)
 {
 	BaseData = InBaseData;
-	TableData = InTableData;
+	TableData = *InTableData;
 	FieldIndex = Index;
 
 	InitVisual();
 }
 
+void AMBBaseMergeItemActor::SetPooled(bool Pooled)
+{
+	// item data is kept until the next Initialize, interaction can still use it after the actor is released
+	if (Pooled)
+		ResetPooledState();
+
+	SetDormant(Pooled);
+}
+
+void AMBBaseMergeItemActor::ResetPooledState()
+{
+	// blueprint animations are timelines and latent nodes like Delay or MoveComponentTo
+	TArray<UTimelineComponent*> Timelines;
+	GetComponents<UTimelineComponent>(Timelines);
+
+	for (auto Timeline : Timelines)
+	{
+		Timeline->Stop();
+	}
+
+	GetWorld()->GetLatentActionManager().RemoveActionsForObject(this);
+	GetWorldTimerManager().ClearAllTimersForObject(this);
+
+	Sprite->SetRelativeTransform(SpriteRelativeTransform);
+	Sprite->SetSpriteColor(SpriteColor);
+}
+
+void AMBBaseMergeItemActor::SetDormant(bool Dormant)
+{
+	SetActorHiddenInGame(Dormant);
+	SetActorEnableCollision(!Dormant);
+	SetActorTickEnabled(!Dormant);
+}
+
 void AMBBaseMergeItemActor::HandleInteraction()
 {
 	if (!TableData.Interactable)
@@ -84,7 +122,7 @@ void AMBBaseMergeItemActor::HandleInteraction()
 
 bool AMBBaseMergeItemActor::GenerateNewItem()
 {
-	auto FieldManager = Cast<AMBMergeFieldManager>(UGameplayStatics::GetActorOfClass(GetWorld(), AMBMergeFieldManager::StaticClass()));
+	check(FieldManager);
 
 	return FieldManager->GenerateNewItemFromAnother(this);
 }
@@ -119,7 +157,7 @@ void AMBBaseMergeItemActor::AddConsumableValue()
 
 	PlayAddConsumableAnimation(TableData.AddValueType);
 
-	auto FieldManager = Cast<AMBMergeFieldManager>(UGameplayStatics::GetActorOfClass(GetWorld(), AMBMergeFieldManager::StaticClass()));
+	check(FieldManager);
 
 	FieldManager->DestroyItem(FieldIndex);
 	FieldManager->DeselectCurrentIndex();
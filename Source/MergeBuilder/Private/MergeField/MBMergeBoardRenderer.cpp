@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MergeField/MBMergeBoardRenderer.h"
+#include "MergeSubsystem.h"
+#include "PaperSprite.h"
+
+UMBMergeBoardRenderer::UMBMergeBoardRenderer()
+{
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	CellSprites.SetNumZeroed(MergeFieldCellsNum);
+	CellTransforms.Init(FTransform::Identity, MergeFieldCellsNum);
+	CellColors.Init(FLinearColor::White, MergeFieldCellsNum);
+}
+
+void UMBMergeBoardRenderer::SetCell(const FIntPoint& Index, UPaperSprite* Sprite, const FTransform& Transform, const FLinearColor& Color)
+{
+	const int32 Cell = Index.Y * MergeFieldWidth + Index.X;
+	check(CellSprites.IsValidIndex(Cell));
+
+	CellSprites[Cell] = Sprite;
+	CellTransforms[Cell] = Transform;
+	CellColors[Cell] = Color;
+
+	CellsDirty = true;
+}
+
+void UMBMergeBoardRenderer::ClearCell(const FIntPoint& Index)
+{
+	const int32 Cell = Index.Y * MergeFieldWidth + Index.X;
+	check(CellSprites.IsValidIndex(Cell));
+
+	if (!CellSprites[Cell])
+		return;
+
+	CellSprites[Cell] = nullptr;
+
+	CellsDirty = true;
+}
+
+void UMBMergeBoardRenderer::FlushCells()
+{
+	if (!CellsDirty)
+		return;
+
+	CellsDirty = false;
+
+	ClearInstances();
+
+	for (int32 Cell = 0; Cell < CellSprites.Num(); Cell++)
+	{
+		if (!CellSprites[Cell])
+			continue;
+
+		AddInstance(CellTransforms[Cell], CellSprites[Cell], true, CellColors[Cell]);
+	}
+}
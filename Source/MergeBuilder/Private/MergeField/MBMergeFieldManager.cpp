@@ -16,6 +16,8 @@ AMBMergeFieldManager::AMBMergeFieldManager()
 	TArray<AMBBaseMergeItemActor*> ZeroRow;
 	ZeroRow.SetNumZeroed(MergeFieldSize.X);
 	FieldItems.Init(ZeroRow, MergeFieldSize.Y);
+
+	BoardRenderer = CreateDefaultSubobject<UMBMergeBoardRenderer>(FName("BoardRenderer"));
 }
 
 // Called when the game starts or when spawned
@@ -25,6 +27,166 @@ void AMBMergeFieldManager::BeginPlay()
 
 	auto MergeSystem = GetGameInstance()->GetSubsystem<UMergeSubsystem>();
 	MergeSystem->OnGetReward.AddDynamic(this, &AMBMergeFieldManager::InitRewardItem);
+
+	WarmUpPool();
+}
+
+void AMBMergeFieldManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UE_LOG(LogTemp, Log, TEXT("AMBMergeFieldManager::EndPlay() - %d item spawns avoided by pool"), SpawnsAvoidedByPool);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AMBMergeFieldManager::WarmUpPool()
+{
+	check(SpawnItemsClass);
+
+	FTransform ParkingTransform = FTransform::Identity;
+	ParkingTransform.SetLocation(PoolParkingLocation);
+
+	ItemActorsPool.Reserve(PoolWarmUpSize);
+
+	for (int32 i = ItemActorsPool.Num(); i < PoolWarmUpSize; i++)
+	{
+		auto ItemActor = GetWorld()->SpawnActor<AMBBaseMergeItemActor>(SpawnItemsClass, ParkingTransform);
+		ItemActor->FieldManager = this;
+		ItemActor->SetPooled(true);
+		ItemActorsPool.Add(ItemActor);
+	}
+
+	if (!SelectionActor && SelectionActorClass)
+	{
+		SelectionActor = GetWorld()->SpawnActor<AActor>(SelectionActorClass, ParkingTransform);
+		SelectionActor->SetActorHiddenInGame(true);
+	}
+}
+
+AMBBaseMergeItemActor* AMBMergeFieldManager::AcquireItemActor(const FTransform& Transform)
+{
+	while (ItemActorsPool.Num() > 0)
+	{
+		auto ItemActor = ItemActorsPool.Pop(false);
+
+		if (!IsValid(ItemActor))
+			continue;
+
+		ItemActor->SetActorTransform(Transform);
+		ItemActor->SetPooled(false);
+
+		SpawnsAvoidedByPool++;
+
+		return ItemActor;
+	}
+
+	auto ItemActor = GetWorld()->SpawnActor<AMBBaseMergeItemActor>(SpawnItemsClass, Transform);
+	ItemActor->FieldManager = this;
+
+	return ItemActor;
+}
+
+void AMBMergeFieldManager::ReleaseItemActor(AMBBaseMergeItemActor* ItemActor)
+{
+	if (!IsValid(ItemActor))
+		return;
+
+	if (TouchStartItem == ItemActor)
+		TouchStartItem = nullptr;
+
+	PromoteItem(ItemActor, 0.0f);
+
+	ItemActor->SetPooled(true);
+	ItemActor->SetActorLocation(PoolParkingLocation);
+
+	ItemActorsPool.Add(ItemActor);
+}
+
+void AMBMergeFieldManager::PromoteItem(AMBBaseMergeItemActor* Item, float Duration)
+{
+	if (!IsValid(Item))
+		return;
+
+	if (Item->RenderedIndex != FIntPoint(-1, -1))
+	{
+		BoardRenderer->ClearCell(Item->RenderedIndex);
+		Item->RenderedIndex = FIntPoint(-1, -1);
+	}
+
+	Item->Sprite->SetVisibility(true);
+
+	if (Duration > 0.0f)
+	{
+		FTimerDelegate RestDelegate = FTimerDelegate::CreateUObject(this, &AMBMergeFieldManager::RestItem, Item);
+		GetWorldTimerManager().SetTimer(Item->PromoteTimerHandle, RestDelegate, Duration, false);
+	}
+	else
+	{
+		GetWorldTimerManager().ClearTimer(Item->PromoteTimerHandle);
+	}
+}
+
+void AMBMergeFieldManager::RestItem(AMBBaseMergeItemActor* Item)
+{
+	if (!IsValid(Item))
+		return;
+
+	GetWorldTimerManager().ClearTimer(Item->PromoteTimerHandle);
+
+	// pooled, dormant or dragged items are not on the board
+	if (Item->IsHidden() || GetItemAtIndex(Item->FieldIndex) != Item)
+		return;
+
+	if (InDrag && Item == TouchStartItem)
+		return;
+
+	UPaperSprite* ItemSprite = Item->Sprite->GetSprite();
+	if (!ItemSprite)
+		return;
+
+	if (Item->RenderedIndex != FIntPoint(-1, -1))
+		BoardRenderer->ClearCell(Item->RenderedIndex);
+
+	FVector Location;
+	GetLocationForIndex(Item->FieldIndex, Location);
+	Item->SetActorLocation(Location);
+
+	// sprite transform of not animated item at its cell
+	const auto DefaultItem = SpawnItemsClass->GetDefaultObject<AMBBaseMergeItemActor>();
+	const FTransform SpriteTransform = DefaultItem->Sprite->GetRelativeTransform() * FTransform(Location);
+
+	BoardRenderer->SetCell(Item->FieldIndex, ItemSprite, SpriteTransform, Item->Sprite->GetSpriteColor());
+
+	Item->Sprite->SetVisibility(false);
+	Item->RenderedIndex = Item->FieldIndex;
+}
+
+void AMBMergeFieldManager::ShowSelectionActor(const FVector& Location)
+{
+	if (!SelectionActor)
+	{
+		FTransform SpawnTransform = FTransform::Identity;
+		SpawnTransform.SetLocation(Location);
+		SelectionActor = GetWorld()->SpawnActor<AActor>(SelectionActorClass, SpawnTransform);
+	}
+	else
+	{
+		SelectionActor->SetActorLocation(Location);
+		SpawnsAvoidedByPool++;
+	}
+
+	SelectionActor->SetActorHiddenInGame(false);
+	SelectionShown = true;
+}
+
+void AMBMergeFieldManager::HideSelectionActor()
+{
+	SelectionShown = false;
+
+	if (!SelectionActor)
+		return;
+
+	SelectionActor->SetActorHiddenInGame(true);
+	SelectionActor->SetActorLocation(PoolParkingLocation);
 }
 
 // Called every frame
@@ -32,37 +194,100 @@ void AMBMergeFieldManager::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	BoardRenderer->FlushCells();
+
 }
 
 void AMBMergeFieldManager::InitializeField()
 {
-	DestroyAllItems();
-
 	auto MergeSystem = GetGameInstance()->GetSubsystem<UMergeSubsystem>();
 
 	check(MergeSystem);
 	check(MergeItemsDataTable);
 	check(SpawnItemsClass);
 
+	int32 SpawnedItemsNum = 0;
+
 	for (int32 y = 0; y < MergeFieldSize.Y; y++)
 	{
 		for (int32 x = 0; x < MergeFieldSize.X; x++)
 		{
 			FIntPoint ID = FIntPoint(x, y);
 			FMergeFieldItem Item;
-			if (!MergeSystem->GetItemAt(ID, Item))
+			const bool HasItem = MergeSystem->GetItemAt(ID, Item);
+
+			auto& ItemActor = FieldItems[y][x];
+
+			if (IsValid(ItemActor))
+			{
+				// keep actor if it still shows the same item
+				if (HasItem && Item == ItemActor->BaseData &&
+					Item.IsDusty == ItemActor->BaseData.IsDusty && Item.IsInBox == ItemActor->BaseData.IsInBox)
+				{
+					FVector Location;
+					GetLocationForIndex(ID, Location);
+
+					ItemActor->BaseData = Item;
+					ItemActor->SetActorLocation(Location);
+					ItemActor->SetDormant(false);
+					RestItem(ItemActor);
+					continue;
+				}
+
+				ReleaseItemActor(ItemActor);
+				ItemActor = nullptr;
+			}
+
+			if (!HasItem)
 				continue;
 
 			SpawnItemAtIndex(Item, ID);
+			SpawnedItemsNum++;
 		}
 	}
 
+	UE_LOG(LogTemp, Log, TEXT("AMBMergeFieldManager::InitializeField() - %d items respawned"), SpawnedItemsNum);
+
+	BoardRenderer->SetVisibility(true);
+
 	InitRewardItem();
 
 	GetWorld()->GetTimerManager().SetTimer(PossibleMergeAnimTimerHandle, this,
 		&AMBMergeFieldManager::TryShowPossibleMergeAnimation, 7.0f, true);
 }
 
+void AMBMergeFieldManager::SetFieldDormant()
+{
+	if (InDrag && IsValid(TouchStartItem))
+	{
+		// dragged item was removed from the merge field on drag start, return it to its cell
+		PlaceItemAtIndex(TouchStartItem->GetFieldIndex(), TouchStartItem);
+
+		auto MergeSystem = GetGameInstance()->GetSubsystem<UMergeSubsystem>();
+		MergeSystem->SaveField();
+	}
+
+	InDrag = false;
+	TouchStartItem = nullptr;
+
+	DeselectCurrentIndex();
+
+	for (auto& Row : FieldItems)
+	{
+		for (auto& Item : Row)
+		{
+			if (!IsValid(Item))
+				continue;
+
+			Item->SetDormant(true);
+		}
+	}
+
+	BoardRenderer->SetVisibility(false);
+
+	GetWorld()->GetTimerManager().ClearTimer(PossibleMergeAnimTimerHandle);
+}
+
 void AMBMergeFieldManager::InitRewardItem()
 {
 	auto MergeSystem = GetGameInstance()->GetSubsystem<UMergeSubsystem>();
@@ -70,11 +295,7 @@ void AMBMergeFieldManager::InitRewardItem()
 	FMergeFieldItem RewardItem;
 	if (MergeSystem->GetFirstReward(RewardItem))
 	{
-		FString RowName = UMBUtilityFunctionLibrary::EnumToString("EMergeItemType", (int32)RewardItem.Type);
-
-		const FMergeItemChainRow* RowStruct = MergeItemsDataTable->FindRow<FMergeItemChainRow>(FName(RowName), "AMBMergeFieldManager::InitRewardItem()");
-
-		RewardActor->Initialize(RewardItem, RowStruct->ItemsChain[RewardItem.Level - 1], FIntPoint(-1, -1));
+		RewardActor->Initialize(RewardItem, MergeSystem->GetItemData(RewardItem), FIntPoint(-1, -1));
 		RewardActor->SetActorHiddenInGame(false);
 	}
 	else
@@ -93,7 +314,7 @@ void AMBMergeFieldManager::OpenInBoxItems(const TArray<FIntPoint>& Indexes)
 		MergeSubsystem->OpenInBoxItem(Index, Item);
 
 		auto ItemAtIndex = FieldItems[Index.Y][Index.X];
-		ItemAtIndex->Destroy();
+		ReleaseItemActor(ItemAtIndex);
 
 		auto SpawnedItemActor = SpawnItemAtIndex(Item, Index);
 	}
@@ -113,58 +334,24 @@ void AMBMergeFieldManager::SellItem(AMBBaseMergeItemActor* ItemToSell)
 
 void AMBMergeFieldManager::TryShowPossibleMergeAnimation()
 {
-	TArray<AMBBaseMergeItemActor*> AllItems;
-
-	for (auto& Row : FieldItems)
-	{
-		for (auto& Item : Row)
-		{
-			if (!IsValid(Item))
-				continue;
-
-			AllItems.Add(Item);
-		}
-	}
-
-	Shuffle(AllItems);
-
-	TArray<FMergeFieldItem> CheckedItems;
-	for (auto FirstItem : AllItems)
-	{
-		if (FirstItem->BaseData.IsInBox || FirstItem->BaseData.IsDusty)
-			continue;
-		
-		if (CheckedItems.Contains(FirstItem->BaseData))
-			continue;
+	auto MergeSubsystem = GetGameInstance()->GetSubsystem<UMergeSubsystem>();
 
-		CheckedItems.Add(FirstItem->BaseData);
+	FIntPoint FirstIndex, SecondIndex;
+	if (!MergeSubsystem->GetRandomMergeablePair(FirstIndex, SecondIndex))
+		return;
 
-		FString RowName = UMBUtilityFunctionLibrary::EnumToString("EMergeItemType", (int32)FirstItem->BaseData.Type);
-		const FMergeItemChainRow* RowStruct = MergeItemsDataTable->FindRow<FMergeItemChainRow>(FName(RowName), "");
-		if (!RowStruct)
-			continue;
+	auto FirstItem = GetItemAtIndex(FirstIndex);
+	auto SecondItem = GetItemAtIndex(SecondIndex);
 
-		// if this is a last level item
-		if (RowStruct->ItemsChain.Num() <= FirstItem->BaseData.Level)
-			continue;
-		
-		for (auto SecondItem : AllItems)
-		{
-			if (FirstItem == SecondItem)
-				continue;
+	if (!IsValid(FirstItem) || !IsValid(SecondItem))
+		return;
 
-			if (SecondItem->BaseData.IsInBox)
-				continue;
+	FVector Direction = (SecondItem->GetActorLocation() - FirstItem->GetActorLocation()).GetSafeNormal();
+	PromoteItem(FirstItem, PromotedItemDuration);
+	PromoteItem(SecondItem, PromotedItemDuration);
 
-			if (FirstItem->BaseData == SecondItem->BaseData)
-			{
-				FVector Direction = (SecondItem->GetActorLocation() - FirstItem->GetActorLocation()).GetSafeNormal();
-				FirstItem->PlayPossibleMergeAnimation(Direction);
-				SecondItem->PlayPossibleMergeAnimation(-1*Direction);
-				return;
-			}
-		}
-	}
+	FirstItem->PlayPossibleMergeAnimation(Direction);
+	SecondItem->PlayPossibleMergeAnimation(-1*Direction);
 }
 
 AMBBaseMergeItemActor* AMBMergeFieldManager::SpawnItemAtIndex(const FMergeFieldItem& Item, const FIntPoint& Index)
@@ -175,57 +362,25 @@ AMBBaseMergeItemActor* AMBMergeFieldManager::SpawnItemAtIndex(const FMergeFieldI
 	FTransform SpawnTransform = FTransform::Identity;
 	SpawnTransform.SetLocation(Location);
 
-	auto SpawnedItem = GetWorld()->SpawnActor<AMBBaseMergeItemActor>(SpawnItemsClass, SpawnTransform);
-
-	FString RowName = UMBUtilityFunctionLibrary::EnumToString("EMergeItemType", (int32)Item.Type);
+	auto MergeSystem = GetGameInstance()->GetSubsystem<UMergeSubsystem>();
 
-	const FMergeItemChainRow* RowStruct = MergeItemsDataTable->FindRow<FMergeItemChainRow>(FName(RowName), "AMBMergeFieldManager::SpawnItemAtIndex()");
+	const FMergeItemData* ItemData = MergeSystem->GetItemData(Item);
 
-	if (!RowStruct)
+	if (!ItemData)
 	{
-		UE_LOG(LogTemp, Error, TEXT("AMBMergeFieldManager::SpawnItemAtIndex() - No item with type %s in table"), *RowName);
+		UE_LOG(LogTemp, Error, TEXT("AMBMergeFieldManager::SpawnItemAtIndex() - No item with type %d and level %d in table"), (int32)Item.Type, Item.Level);
 		return nullptr;
 	}
 
-	if (RowStruct->ItemsChain.Num() < Item.Level)
-	{
-		UE_LOG(LogTemp, Error, TEXT("AMBMergeFieldManager::SpawnItemAtIndex() - Item with type %s has no level %d"), *RowName, Item.Level);
-		return nullptr;
-	}
-
-	FMergeItemData ItemData = RowStruct->ItemsChain[Item.Level - 1];
+	auto SpawnedItem = AcquireItemActor(SpawnTransform);
 
 	SpawnedItem->Initialize(Item, ItemData, Index);
 
 	FieldItems[Index.Y][Index.X] = SpawnedItem;
 
-	return SpawnedItem;
-}
+	RestItem(SpawnedItem);
 
-void AMBMergeFieldManager::DestroyAllItems()
-{
-	for (auto& Row : FieldItems)
-	{
-		for (auto& Item : Row)
-		{
-			if (!IsValid(Item))
-				continue;
-
-			if (Item->IsPendingKill())
-				continue;
-
-			Item->Destroy();
-			Item = nullptr;
-		}
-	}
-
-	if (SelectionActor)
-	{
-		SelectionActor->Destroy();
-		SelectionActor = nullptr;
-	}
-
-	GetWorld()->GetTimerManager().ClearTimer(PossibleMergeAnimTimerHandle);
+	return SpawnedItem;
 }
 
 bool AMBMergeFieldManager::GetLocationForIndex(const FIntPoint& Index, FVector& OutLocation)
@@ -300,10 +455,11 @@ void AMBMergeFieldManager::HandleReleaseTouchOnIndex(const FIntPoint& Index)
 			{
 				bool MergeWithDusty = ItemAtIndex->BaseData.IsDusty;
 				FVector MergeItemLocation = (TouchStartItem->GetActorLocation() + ItemAtIndex->GetActorLocation()) / 2.0f;
-				TouchStartItem->Destroy();
-				ItemAtIndex->Destroy();
+				ReleaseItemActor(TouchStartItem);
+				ReleaseItemActor(ItemAtIndex);
 
 				auto MergedItemActor = SpawnItemAtIndex(MergedItem, Index);
+				PromoteItem(MergedItemActor, PromotedItemDuration);
 				MergedItemActor->SetActorLocation(MergeItemLocation);
 				FVector IndexLocation;
 				GetLocationForIndex(Index, IndexLocation);
@@ -374,6 +530,7 @@ void AMBMergeFieldManager::HandleClickOnIndex(const FIntPoint& Index)
 		auto ItemAtIndex = GetItemAtIndex(Index);
 		if (ItemAtIndex)
 		{
+			PromoteItem(ItemAtIndex, PromotedItemDuration);
 			ItemAtIndex->HandleInteraction();
 
 			auto MergeSubsystem = GetGameInstance()->GetSubsystem<UMergeSubsystem>();
@@ -427,6 +584,8 @@ void AMBMergeFieldManager::StartDrag()
 
 	DeselectCurrentIndex();
 
+	PromoteItem(TouchStartItem, 0.0f);
+
 	FIntPoint DraggedIndex = TouchStartItem->GetFieldIndex();
 
 	FieldItems[DraggedIndex.Y][DraggedIndex.X] = nullptr;
@@ -472,6 +631,8 @@ void AMBMergeFieldManager::PlaceItemAtIndex(const FIntPoint& Index, AMBBaseMerge
 
 	FVector IndexLocation;
 	GetLocationForIndex(Index, IndexLocation);
+
+	PromoteItem(Item, PromotedItemDuration);
 	Item->MoveToLocation(IndexLocation);
 
 	FieldItems[Index.Y][Index.X] = Item;
@@ -496,9 +657,7 @@ void AMBMergeFieldManager::SelectIndex(const FIntPoint& Index)
 	FVector IndexLocation;
 	GetLocationForIndex(Index, IndexLocation);
 	IndexLocation.Z -= 1.0f;
-	FTransform SpawnTransform = FTransform::Identity;
-	SpawnTransform.SetLocation(IndexLocation);
-	SelectionActor = GetWorld()->SpawnActor<AActor>(SelectionActorClass, SpawnTransform);
+	ShowSelectionActor(IndexLocation);
 	
 	OnItemSelected.Broadcast(ActorAtIndex);
 }
@@ -507,10 +666,9 @@ void AMBMergeFieldManager::DeselectCurrentIndex()
 {
 	SelectedIndex = FIntPoint(-1, -1);
 
-	if (SelectionActor)
+	if (SelectionShown)
 	{
-		SelectionActor->Destroy();
-		SelectionActor = nullptr;
+		HideSelectionActor();
 		OnItemDeselected.Broadcast();
 	}
 }
@@ -523,7 +681,7 @@ void AMBMergeFieldManager::DestroyItem(const FIntPoint& Index)
 
 	auto Item = GetItemAtIndex(Index);
 
-	Item->Destroy();
+	ReleaseItemActor(Item);
 
 	FieldItems[Index.Y][Index.X] = nullptr;
 }
@@ -540,7 +698,9 @@ bool AMBMergeFieldManager::GenerateNewItemFromAnother(AMBBaseMergeItemActor* Sou
 	}
 
 	FSpawnItemData ItemToSpawn;
-	MergeSystem->GetRandomItemWeight(SourceItem->TableData.SpawnableItems, ItemToSpawn);
+	if (!MergeSystem->GetRandomSpawnItem(SourceItem->BaseData, ItemToSpawn))
+		return false;
+
 	MergeSystem->InitItem(ItemToSpawn.Item);
 
 	GenerateNewItemFromLocation(SourceItem->FieldIndex, ItemToSpawn.Item);
@@ -580,6 +740,7 @@ AMBBaseMergeItemActor* AMBMergeFieldManager::GenerateNewItemFromLocation(const F
 
 	auto SpawnedItem = SpawnItemAtIndex(ItemToSpawn, ClosestIndex);
 
+	PromoteItem(SpawnedItem, PromotedItemDuration);
 	SpawnedItem->SetActorLocation(SourceLocation);
 	FVector DestinationLocation;
 	GetLocationForIndex(ClosestIndex, DestinationLocation);
@@ -3,7 +3,53 @@
 
 #include "MergeSystem/MergeSubsystem.h"
 #include "MBUtilityFunctionLibrary.h"
-#include "JsonObjectConverter.h"
+#include "Utilities/MBJsonCodec.h"
+#include "Utilities/MBSaveCoordinator.h"
+
+namespace
+{
+	// For every source cell holds all other cells ordered by manhattan distance,
+	// inside one distance ring by Y offset and then by X offset
+	struct FClosestCellsTable
+	{
+		uint8 Cells[MergeFieldCellsNum][MergeFieldCellsNum - 1];
+
+		FClosestCellsTable()
+		{
+			for (int32 SourceCell = 0; SourceCell < MergeFieldCellsNum; SourceCell++)
+			{
+				const FIntPoint Source = FIntPoint(SourceCell % MergeFieldWidth, SourceCell / MergeFieldWidth);
+				int32 Num = 0;
+
+				for (int32 Radius = 1; Radius <= MergeFieldWidth + MergeFieldHeight - 2; Radius++)
+				{
+					for (int32 i = -Radius; i <= Radius; i++)
+					{
+						const int32 RemainX = Radius - FMath::Abs(i);
+
+						for (int32 j = -RemainX; j <= RemainX; j += FMath::Max(1, 2 * RemainX))
+						{
+							const FIntPoint Target = Source + FIntPoint(j, i);
+
+							if (Target.X < 0 || Target.Y < 0 || Target.X >= MergeFieldWidth || Target.Y >= MergeFieldHeight)
+								continue;
+
+							Cells[SourceCell][Num++] = Target.Y * MergeFieldWidth + Target.X;
+						}
+					}
+				}
+
+				check(Num == MergeFieldCellsNum - 1);
+			}
+		}
+	};
+
+	const FClosestCellsTable& GetClosestCellsTable()
+	{
+		static const FClosestCellsTable Table;
+		return Table;
+	}
+}
 
 UMergeSubsystem::UMergeSubsystem()
 {
@@ -24,15 +70,34 @@ UMergeSubsystem::UMergeSubsystem()
 
 void UMergeSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
-	TArray<FMergeFieldItem> ZeroRow;
-	ZeroRow.SetNumZeroed(MergeFieldSize.X);
+	BuildItemsCatalog();
 
-	MergeField.Init(ZeroRow, MergeFieldSize.Y);
+	// spent and rewarded items are committed together with the city, quests and account
+	PreCommitHandle = FMBSaveCoordinator::Get().OnPreCommit.AddUObject(this, &UMergeSubsystem::FlushField);
+
+	ClearField();
+
+	const bool BinaryLoaded = UMBUtilityFunctionLibrary::ReadBinaryFromStorage("Inventory", [this](FArchive& Ar, int32 Version)
+	{
+		SerializeField(Ar, Version);
+	});
+
+	if (BinaryLoaded)
+	{
+		// loaded field is the same as in storage
+		FieldDirty = false;
+		return;
+	}
+
+	ClearField();
+	RewardsQueue.Empty();
 
 	FString SavedData;
 	if (UMBUtilityFunctionLibrary::ReadFromStorage("Inventory", SavedData))
 	{
+		// migrate field from json storage
 		ParseField(SavedData);
+		SaveField();
 	}
 	else
 	{
@@ -42,7 +107,205 @@ void UMergeSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 
 void UMergeSubsystem::Deinitialize()
 {
-	SaveField();
+	FMBSaveCoordinator::Get().OnPreCommit.Remove(PreCommitHandle);
+
+	FlushField();
+}
+
+void UMergeSubsystem::BuildItemsCatalog()
+{
+	const UEnum* ItemTypeEnum = StaticEnum<EMergeItemType>();
+	// skip autogenerated _MAX value
+	const int32 TypesNum = ItemTypeEnum->NumEnums() - 1;
+
+	ItemsCatalog.Reset();
+	ItemChainOffsets.Init(0, TypesNum + 1);
+
+	for (int32 TypeIndex = 0; TypeIndex < TypesNum; TypeIndex++)
+	{
+		ItemChainOffsets[TypeIndex] = ItemsCatalog.Num();
+
+		FString RowName = UMBUtilityFunctionLibrary::EnumToString("EMergeItemType", TypeIndex);
+
+		const FMergeItemChainRow* RowStruct = MergeItemsDataTable->FindRow<FMergeItemChainRow>(FName(RowName), "", false);
+
+		if (!RowStruct)
+			continue;
+
+		for (const auto& ItemData : RowStruct->ItemsChain)
+		{
+			ItemsCatalog.Add(&ItemData);
+		}
+	}
+
+	ItemChainOffsets[TypesNum] = ItemsCatalog.Num();
+
+	ItemSamplers.Reset();
+	ItemSamplers.SetNum(ItemsCatalog.Num());
+
+	for (int32 i = 0; i < ItemsCatalog.Num(); i++)
+	{
+		ItemSamplers[i].Build(ItemsCatalog[i]->SpawnableItems);
+	}
+}
+
+const FMergeItemData* UMergeSubsystem::GetItemData(const FMergeFieldItem& Item) const
+{
+	if (Item.Level < 1 || Item.Level > GetItemMaxLevel(Item.Type))
+		return nullptr;
+
+	return ItemsCatalog[ItemChainOffsets[(int32)Item.Type] + Item.Level - 1];
+}
+
+int32 UMergeSubsystem::GetItemMaxLevel(EMergeItemType Type) const
+{
+	const int32 TypeIndex = (int32)Type;
+
+	if (TypeIndex + 1 >= ItemChainOffsets.Num())
+		return 0;
+
+	return ItemChainOffsets[TypeIndex + 1] - ItemChainOffsets[TypeIndex];
+}
+
+void UMergeSubsystem::ClearField()
+{
+	for (auto& Item : MergeField)
+	{
+		Item = FMergeFieldItem();
+	}
+
+	OccupiedMask = 0;
+	DustyMask = 0;
+	InBoxMask = 0;
+
+	UsableItemCells.Empty();
+	NotInBoxItemCells.Empty();
+	MergeableItemKeys.Empty();
+}
+
+void UMergeSubsystem::WriteCell(int32 Cell, const FMergeFieldItem& Item)
+{
+	const uint64 Bit = CellBit(Cell);
+
+	FieldDirty = true;
+
+	const FMergeFieldItem OldItem = MergeField[Cell];
+	const bool OldItemIndexed = (OccupiedMask & ~InBoxMask & Bit) != 0;
+
+	if (OldItemIndexed)
+	{
+		const uint64 OldItemKey = GetItemKey(OldItem);
+
+		RemoveItemCell(NotInBoxItemCells, OldItemKey, Bit);
+
+		if (!(DustyMask & Bit))
+			RemoveItemCell(UsableItemCells, OldItemKey, Bit);
+	}
+
+	MergeField[Cell] = Item;
+
+	OccupiedMask &= ~Bit;
+	DustyMask &= ~Bit;
+	InBoxMask &= ~Bit;
+
+	if (Item.Type != EMergeItemType::None)
+	{
+		OccupiedMask |= Bit;
+
+		if (Item.IsDusty)
+			DustyMask |= Bit;
+
+		if (Item.IsInBox)
+			InBoxMask |= Bit;
+	}
+
+	const bool NewItemIndexed = (OccupiedMask & ~InBoxMask & Bit) != 0;
+
+	if (NewItemIndexed)
+	{
+		const uint64 ItemKey = GetItemKey(Item);
+
+		NotInBoxItemCells.FindOrAdd(ItemKey) |= Bit;
+
+		if (!Item.IsDusty)
+			UsableItemCells.FindOrAdd(ItemKey) |= Bit;
+	}
+
+	if (OldItemIndexed)
+		UpdateMergeableKey(OldItem);
+
+	if (NewItemIndexed)
+		UpdateMergeableKey(Item);
+}
+
+void UMergeSubsystem::RemoveItemCell(TMap<uint64, uint64>& ItemCells, uint64 ItemKey, uint64 Bit)
+{
+	uint64& Cells = ItemCells.FindChecked(ItemKey);
+	Cells &= ~Bit;
+
+	if (!Cells)
+		ItemCells.Remove(ItemKey);
+}
+
+void UMergeSubsystem::UpdateMergeableKey(const FMergeFieldItem& Item)
+{
+	const uint64 ItemKey = GetItemKey(Item);
+
+	// first item of the pair must be usable, second one can be dusty
+	const uint64* NotInBoxCells = NotInBoxItemCells.Find(ItemKey);
+	const bool HasPair = UsableItemCells.Contains(ItemKey) && NotInBoxCells && FMath::CountBits(*NotInBoxCells) >= 2;
+
+	if (!HasPair)
+	{
+		MergeableItemKeys.RemoveSwap(ItemKey);
+		return;
+	}
+
+	if (MergeableItemKeys.Contains(ItemKey))
+		return;
+
+	if (IsLastLevelItem(Item))
+		return;
+
+	MergeableItemKeys.Add(ItemKey);
+}
+
+bool UMergeSubsystem::IsLastLevelItem(const FMergeFieldItem& Item) const
+{
+	return GetItemMaxLevel(Item.Type) <= Item.Level;
+}
+
+bool UMergeSubsystem::HasPossibleMerges() const
+{
+	return MergeableItemKeys.Num() > 0;
+}
+
+bool UMergeSubsystem::GetRandomMergeablePair(FIntPoint& OutFirstIndex, FIntPoint& OutSecondIndex)
+{
+	if (MergeableItemKeys.Num() == 0)
+		return false;
+
+	const uint64 ItemKey = MergeableItemKeys[FMath::RandRange(0, MergeableItemKeys.Num() - 1)];
+
+	const int32 FirstCell = GetRandomCell(UsableItemCells.FindChecked(ItemKey));
+	const int32 SecondCell = GetRandomCell(NotInBoxItemCells.FindChecked(ItemKey) & ~CellBit(FirstCell));
+
+	OutFirstIndex = CellToIndex(FirstCell);
+	OutSecondIndex = CellToIndex(SecondCell);
+
+	return true;
+}
+
+int32 UMergeSubsystem::GetRandomCell(uint64 Cells)
+{
+	check(Cells);
+
+	for (int32 Skip = FMath::RandRange(0, FMath::CountBits(Cells) - 1); Skip > 0; Skip--)
+	{
+		Cells &= Cells - 1;
+	}
+
+	return FMath::CountTrailingZeros64(Cells);
 }
 
 void UMergeSubsystem::InitFieldFromStartTable()
@@ -63,109 +326,177 @@ void UMergeSubsystem::InitFieldFromStartTable()
 			if (Item.Type == EMergeItemType::None)
 				continue;
 
-			MergeField[i][j] = Item;
+			WriteCell(IndexToCell(FIntPoint(j, i)), Item);
 		}
 	}
 }
 
 void UMergeSubsystem::ParseField(const FString& JsonString)
 {
-	TSharedPtr<FJsonObject> JsonObject;
-	
-	if (!UMBUtilityFunctionLibrary::StringToJsonObject(JsonString, JsonObject))
-		return;
+	auto Reader = FMBJsonCodec::CreateReader(JsonString);
 
-	const TSharedPtr<FJsonObject>* FieldObject;
+	EJsonNotation Notation;
+	if (!Reader->ReadNext(Notation) || Notation != EJsonNotation::ObjectStart)
+		return;
 
-	if (JsonObject.Get()->TryGetObjectField("field", FieldObject))
+	while (Reader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
 	{
-		for (int32 i = 0; i < MergeFieldSize.Y; i++)
+		if (Reader->GetIdentifier() == "field" && Notation == EJsonNotation::ObjectStart)
 		{
-			const TSharedPtr<FJsonObject>* RowObject;
-			if (!FieldObject->Get()->TryGetObjectField(FString::FromInt(i), RowObject))
-				continue;
-
-			for (int32 j = 0; j < MergeFieldSize.X; j++)
+			// rows and items are keyed by their index
+			while (Reader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
 			{
-				const TSharedPtr<FJsonObject>* ItemObject;
-				if (!RowObject->Get()->TryGetObjectField(FString::FromInt(j), ItemObject))
+				if (Notation != EJsonNotation::ObjectStart)
+				{
+					FMBJsonCodec::SkipValue(*Reader, Notation);
 					continue;
+				}
+
+				const int32 i = FCString::Atoi(*Reader->GetIdentifier());
 
-				FMergeFieldItem Item;
+				while (Reader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
+				{
+					if (Notation != EJsonNotation::ObjectStart)
+					{
+						FMBJsonCodec::SkipValue(*Reader, Notation);
+						continue;
+					}
 
-				FJsonObjectConverter::JsonObjectToUStruct<FMergeFieldItem>(ItemObject->ToSharedRef(), &Item);
+					const int32 j = FCString::Atoi(*Reader->GetIdentifier());
 
-				MergeField[i][j] = Item;
+					FMergeFieldItem Item;
+					FMBJsonCodec::ReadStruct(*Reader, Item);
+
+					if (IsValidIndex(FIntPoint(j, i)))
+						WriteCell(IndexToCell(FIntPoint(j, i)), Item);
+				}
 			}
 		}
+		else if (Reader->GetIdentifier() == "rewards" && Notation == EJsonNotation::ArrayStart)
+		{
+			FMBJsonCodec::ReadStructArray(*Reader, RewardsQueue);
+		}
+		else
+		{
+			FMBJsonCodec::SkipValue(*Reader, Notation);
+		}
 	}
+}
 
-	const TArray<TSharedPtr<FJsonValue>>* RewardsArray;
-	if (JsonObject.Get()->TryGetArrayField("rewards", RewardsArray))
+void UMergeSubsystem::SaveField()
+{
+	FieldDirty = true;
+
+	auto World = GetWorld();
+
+	if (!World)
 	{
-		for (const auto& Value : *RewardsArray)
-		{
-			TSharedPtr<FJsonObject> RewardObject = Value->AsObject();
+		FlushField();
+		return;
+	}
 
-			FMergeFieldItem Item;
+	// timer is not restarted so constant changes can't delay saving forever
+	if (World->GetTimerManager().IsTimerActive(SaveFieldTimerHandle))
+		return;
 
-			FJsonObjectConverter::JsonObjectToUStruct<FMergeFieldItem>(RewardObject.ToSharedRef(), &Item);
+	World->GetTimerManager().SetTimer(SaveFieldTimerHandle, this, &UMergeSubsystem::FlushField, SaveFieldDelay, false);
+}
 
-			RewardsQueue.Add(Item);
-		}
+void UMergeSubsystem::FlushField()
+{
+	if (auto World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(SaveFieldTimerHandle);
+	}
+
+	if (!FieldDirty)
+		return;
+
+	FieldDirty = false;
+
+	WriteField();
+}
+
+void UMergeSubsystem::WriteField()
+{
+	UMBUtilityFunctionLibrary::SaveBinaryToStorage("Inventory", InventoryStorageVersion, [this](FArchive& Ar, int32 Version)
+	{
+		SerializeField(Ar, Version);
+	});
+
+	if (UMBUtilityFunctionLibrary::IsJsonExportEnabled())
+	{
+		ExportFieldJson();
 	}
 }
 
-void UMergeSubsystem::SaveField()
+void UMergeSubsystem::SerializeField(FArchive& Ar, int32 Version)
+{
+	// mask of occupied cells and then their items in cell order
+	uint64 Cells = OccupiedMask;
+	Ar << Cells;
+
+	for (Cells &= FieldMask; Cells; Cells &= Cells - 1)
+	{
+		const int32 Cell = FMath::CountTrailingZeros64(Cells);
+
+		FMergeFieldItem Item = MergeField[Cell];
+		Ar << Item;
+
+		if (Ar.IsLoading())
+			WriteCell(Cell, Item);
+	}
+
+	Ar << RewardsQueue;
+}
+
+void UMergeSubsystem::ExportFieldJson()
 {
-	TSharedPtr<FJsonObject> JsonObject = MakeShared<FJsonObject>();
+	FString StringData;
+	auto Writer = FMBJsonCodec::CreateWriter(StringData);
 
-	TSharedPtr<FJsonObject> FieldObject = MakeShared<FJsonObject>();
+	Writer->WriteObjectStart();
+	Writer->WriteObjectStart("field");
 
 	for (int32 i = 0; i < MergeFieldSize.Y; i++)
 	{
-		TSharedPtr<FJsonObject> RowObject = MakeShared<FJsonObject>();
+		Writer->WriteObjectStart(FString::FromInt(i));
 
 		for (int32 j = 0; j < MergeFieldSize.X; j++)
 		{
-			const FMergeFieldItem& Item = MergeField[i][j];
+			const int32 Cell = IndexToCell(FIntPoint(j, i));
 
-			if (Item.Type == EMergeItemType::None)
+			if (!(OccupiedMask & CellBit(Cell)))
 				continue;
 
-			TSharedPtr<FJsonObject> ItemObject;
-
-			ItemObject = FJsonObjectConverter::UStructToJsonObject<FMergeFieldItem>(Item);
-
-			RowObject->SetObjectField(FString::FromInt(j), ItemObject);
+			FMBJsonCodec::WriteStruct(*Writer, FString::FromInt(j), MergeField[Cell]);
 		}
 
-		FieldObject->SetObjectField(FString::FromInt(i), RowObject);
+		Writer->WriteObjectEnd();
 	}
 
-	JsonObject->SetObjectField("field", FieldObject);
+	Writer->WriteObjectEnd();
 
-	TArray<TSharedPtr<FJsonValue>> RewardValues;
+	Writer->WriteArrayStart("rewards");
 
 	for (const auto& Reward : RewardsQueue)
 	{
-		TSharedPtr<FJsonObject> RewardObject = FJsonObjectConverter::UStructToJsonObject<FMergeFieldItem>(Reward);
-		TSharedPtr<FJsonValueObject> RewardValue = MakeShared<FJsonValueObject>(RewardObject);
-
-		RewardValues.Add(RewardValue);
+		FMBJsonCodec::WriteStruct(*Writer, Reward);
 	}
 
-	JsonObject->SetArrayField("rewards", RewardValues);
-
-	FString StringData;
-	UMBUtilityFunctionLibrary::JsonObjectToString(JsonObject, StringData);
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
 
 	UMBUtilityFunctionLibrary::SaveToStorage("Inventory", StringData);
 }
 
 bool UMergeSubsystem::GetAllItemsInBoxAround(const FIntPoint& Index, TArray<FIntPoint>& OutItemIndexes)
 {
-	if (Index.X < 0 || Index.Y < 0 || Index.X >= MergeFieldSize.X || Index.Y >= MergeFieldSize.Y)
+	if (!IsValidIndex(Index))
+		return false;
+
+	if (!InBoxMask)
 		return false;
 
 	// for all indexes around
@@ -176,15 +507,14 @@ bool UMergeSubsystem::GetAllItemsInBoxAround(const FIntPoint& Index, TArray<FInt
 			if (i == Index.X && j == Index.Y)
 				continue;
 
-			if (i < 0 || j < 0 || i >= MergeFieldSize.X || j >= MergeFieldSize.Y)
-				continue;
+			const FIntPoint AroundIndex = FIntPoint(i, j);
 
-			if (MergeField[j][i].Type == EMergeItemType::None)
+			if (!IsValidIndex(AroundIndex))
 				continue;
 
-			if (MergeField[j][i].IsInBox)
+			if (InBoxMask & CellBit(IndexToCell(AroundIndex)))
 			{
-				OutItemIndexes.Add(FIntPoint(i, j));
+				OutItemIndexes.Add(AroundIndex);
 			}
 		}
 	}
@@ -194,45 +524,40 @@ bool UMergeSubsystem::GetAllItemsInBoxAround(const FIntPoint& Index, TArray<FInt
 
 void UMergeSubsystem::OpenInBoxItem(const FIntPoint& Index, FMergeFieldItem& OutItem)
 {
-	if (Index.X < 0 || Index.Y < 0 || Index.X >= MergeFieldSize.X || Index.Y >= MergeFieldSize.Y)
+	if (!IsValidIndex(Index))
 	{
 		UE_LOG(LogTemp, Error, TEXT("Index out of range"));
 		return;
 	}
+
+	const int32 Cell = IndexToCell(Index);
 	
-	OutItem = MergeField[Index.Y][Index.X];
+	OutItem = MergeField[Cell];
 
 	OutItem.IsDusty = true;
 	OutItem.IsInBox = false;
 
-	MergeField[Index.Y][Index.X] = OutItem;
+	WriteCell(Cell, OutItem);
 }
 
 bool UMergeSubsystem::GetItemAt(const FIntPoint& Index, FMergeFieldItem& OutItem)
 {
-	if (Index.X < 0 || Index.X >= MergeFieldSize.X)
+	if (!IsValidIndex(Index))
 		return false;
 
-	if (Index.Y < 0 || Index.Y >= MergeFieldSize.Y)
-		return false;
-
-	OutItem = MergeField[Index.Y][Index.X];
+	const int32 Cell = IndexToCell(Index);
 
-	if (OutItem.Type == EMergeItemType::None)
-		return false;
+	OutItem = MergeField[Cell];
 
-	return true;
+	return (OccupiedMask & CellBit(Cell)) != 0;
 }
 
 void UMergeSubsystem::SetItemAt(const FIntPoint& Index, const FMergeFieldItem& Item)
 {
-	if (Index.X < 0 || Index.X >= MergeFieldSize.X)
+	if (!IsValidIndex(Index))
 		return;
 
-	if (Index.Y < 0 || Index.Y >= MergeFieldSize.Y)
-		return;
-
-	MergeField[Index.Y][Index.X] = Item;
+	WriteCell(IndexToCell(Index), Item);
 }
 
 bool UMergeSubsystem::TryMergeItems(const FMergeFieldItem& Item, const FIntPoint& MergeIndex, FMergeFieldItem& MergedItem)
@@ -245,24 +570,20 @@ bool UMergeSubsystem::TryMergeItems(const FMergeFieldItem& Item, const FIntPoint
 	if (Item != MergeItem)
 		return false;
 
-	FString RowName = UMBUtilityFunctionLibrary::EnumToString("EMergeItemType", (int32)Item.Type);
-
-	const FMergeItemChainRow* RowStruct = MergeItemsDataTable->FindRow<FMergeItemChainRow>(FName(RowName), "UMergeSubsystem::TryMergeItems()");
-
-	if (!RowStruct)
+	if (!GetItemData(Item))
 	{
-		UE_LOG(LogTemp, Error, TEXT("UMergeSubsystem::TryMergeItems() - No item with type %s in table"), *RowName);
+		UE_LOG(LogTemp, Error, TEXT("UMergeSubsystem::TryMergeItems() - No item with type %d and level %d in table"), (int32)Item.Type, Item.Level);
 		return false;
 	}
 
 	// if this is a last level item
-	if (RowStruct->ItemsChain.Num() <= Item.Level)
+	if (IsLastLevelItem(Item))
 		return false;
 
 	MergedItem.Level = Item.Level + 1;
 	MergedItem.Type = Item.Type;
 
-	MergeField[MergeIndex.Y][MergeIndex.X] = MergedItem;
+	WriteCell(IndexToCell(MergeIndex), MergedItem);
 
 	OnMergeNewItem.Broadcast(MergedItem);
 
@@ -278,93 +599,35 @@ bool UMergeSubsystem::GetClosestFreeIndex(const FIntPoint& Index, FIntPoint& Clo
 		return true;
 	}
 
-	for (int32 i = 1; i <= (MergeFieldSize.X + MergeFieldSize.Y - 2); i++)
-	{
-		TArray<FIntPoint> Variants;
-		GetAllIndexVariants(i, Variants);
-
-		for (const auto& Variant : Variants)
-		{
-			FIntPoint IndexToCheck = Index + Variant;
-
-			if (IndexToCheck.X < 0 || IndexToCheck.X >= MergeFieldSize.X)
-				continue;
+	const uint64 FreeMask = GetFreeMask();
 
-			if (IndexToCheck.Y < 0 || IndexToCheck.Y >= MergeFieldSize.Y)
-				continue;
-
-			if (GetItemAt(IndexToCheck, Item))
-				continue;
-
-			ClosestFreeIndex = IndexToCheck;
-			return true;
-		}
-	}
-	return false;
-}
+	if (!FreeMask)
+		return false;
 
-void UMergeSubsystem::GetAllIndexVariants(int32 IndexSum, TArray<FIntPoint>& Variants)
-{
-	for (int32 i = -IndexSum; i <= IndexSum; i++)
+	for (const uint8 Cell : GetClosestCellsTable().Cells[IndexToCell(Index)])
 	{
-		for (int32 j = -IndexSum; j <= IndexSum; j++)
-		{
-			if ((FMath::Abs(i) + FMath::Abs(j)) != IndexSum)
-				continue;
+		if (!(FreeMask & CellBit(Cell)))
+			continue;
 
-			Variants.Add(FIntPoint(j, i));
-		}
+		ClosestFreeIndex = CellToIndex(Cell);
+		return true;
 	}
+
+	return false;
 }
 
-void UMergeSubsystem::GetRandomItemWeight(const TArray<FSpawnItemData>& Items, FSpawnItemData& OutItem)
+bool UMergeSubsystem::GetRandomSpawnItem(const FMergeFieldItem& Generator, FSpawnItemData& OutItem, const FRandomStream* Stream) const
 {
-	check(Items.Num() > 0);
-
-	// get all types
-	TMap<ESpawnProbability, TArray<FSpawnItemData>> ProbabilityTypes;
-	for (const auto& Item : Items)
-	{
-		if (ProbabilityTypes.Contains(Item.Probability))
-		{
-			ProbabilityTypes[Item.Probability].Add(Item);
-		}
-		else
-		{
-			TArray<FSpawnItemData> ItemArray;
-			ItemArray.Add(Item);
-			ProbabilityTypes.Add(Item.Probability, ItemArray);
-		}
-	}
-
-	// get sum of all weights
-	int32 WeightSum = 0;
-	for (const auto& Probability : ProbabilityTypes)
-	{
-		WeightSum += GetWeightForProbability(Probability.Key);
-	}
-	check(WeightSum > 0);
+	if (!GetItemData(Generator))
+		return false;
 
-	int32 RandNumber = FMath::RandRange(1, WeightSum);
+	const FSpawnItemsSampler& Sampler = ItemSamplers[ItemChainOffsets[(int32)Generator.Type] + Generator.Level - 1];
 
-	int32 PassedWeight = 0;
-	
-	// get weight randow for probability type
-	TArray<FSpawnItemData> SelectedProbabilityItems;
-	for (const auto& Probability : ProbabilityTypes)
-	{
-		PassedWeight += GetWeightForProbability(Probability.Key);
-		if (RandNumber <= PassedWeight)
-		{
-			SelectedProbabilityItems = Probability.Value;
-			break;
-		}
-	}
-
-	// get equal random in probability type group
-	int32 RandIndex = FMath::RandRange(0, SelectedProbabilityItems.Num() - 1);
+	if (Sampler.IsEmpty())
+		return false;
 
-	OutItem = SelectedProbabilityItems[RandIndex];
+	OutItem = Sampler.Sample(Stream);
+	return true;
 }
 
 int32 UMergeSubsystem::GetWeightForProbability(ESpawnProbability Probability)
@@ -382,35 +645,43 @@ int32 UMergeSubsystem::GetWeightForProbability(ESpawnProbability Probability)
 
 bool UMergeSubsystem::HasFreePlace()
 {
-	for (const auto& Row : MergeField)
-	{
-		for (const auto& Item : Row)
-		{
-			if (Item.Type == EMergeItemType::None)
-				return true;
-		}
-	}
+	return GetFreeMask() != 0;
+}
 
-	return false;
+int32 UMergeSubsystem::GetFreePlacesNum()
+{
+	return FMath::CountBits(GetFreeMask());
+}
+
+bool UMergeSubsystem::GetFirstFreeIndex(FIntPoint& OutIndex)
+{
+	const uint64 FreeMask = GetFreeMask();
+
+	if (!FreeMask)
+		return false;
+
+	OutIndex = CellToIndex(FMath::CountTrailingZeros64(FreeMask));
+	return true;
 }
 
 int32 UMergeSubsystem::DecrementRemainItemsToSpawn(const FIntPoint& Index)
 {
-	MergeField[Index.Y][Index.X].RemainItemsToSpawn--;
+	const int32 Cell = IndexToCell(Index);
+
+	MergeField[Cell].RemainItemsToSpawn--;
 
-	return MergeField[Index.Y][Index.X].RemainItemsToSpawn;
+	return MergeField[Cell].RemainItemsToSpawn;
 }
 
 void UMergeSubsystem::InitItem(FMergeFieldItem& OutItem)
 {
-	FString RowName = UMBUtilityFunctionLibrary::EnumToString("EMergeItemType", (int32)OutItem.Type);
-	const FMergeItemChainRow* RowStruct = MergeItemsDataTable->FindRow<FMergeItemChainRow>(FName(RowName), "UMergeSubsystem::InitItem()");
+	const FMergeItemData* ItemData = GetItemData(OutItem);
 	
-	if (!RowStruct)
+	if (!ItemData)
 		return;
 
 	if (OutItem.RemainItemsToSpawn <= 0)
-		OutItem.RemainItemsToSpawn = RowStruct->ItemsChain[OutItem.Level - 1].MaxItemsToSpawn;
+		OutItem.RemainItemsToSpawn = ItemData->MaxItemsToSpawn;
 }
 
 bool UMergeSubsystem::GetFirstReward(FMergeFieldItem& OutItem)
@@ -437,23 +708,23 @@ void UMergeSubsystem::AddNewReward(const FMergeFieldItem& NewRewardItem)
 	OnGetReward.Broadcast();
 }
 
-int32 UMergeSubsystem::GetItemTotalCount(const FMergeFieldItem& Item)
+void UMergeSubsystem::AddNewRewards(const TArray<FMergeFieldItem>& NewRewardItems)
 {
-	int32 Count = 0;
+	if (NewRewardItems.Num() == 0)
+		return;
 
-	for (const auto& Row : MergeField)
-	{
-		for (const auto& RowItem : Row)
-		{
-			if (RowItem.IsDusty || RowItem.IsInBox)
-				continue;
-			
-			if (Item == RowItem)
-				Count++;
-		}
-	}
+	RewardsQueue.Append(NewRewardItems);
+
+	SaveField();
+
+	OnGetReward.Broadcast();
+}
+
+int32 UMergeSubsystem::GetItemTotalCount(const FMergeFieldItem& Item)
+{
+	const uint64* Cells = UsableItemCells.Find(GetItemKey(Item));
 
-	return Count;
+	return Cells ? FMath::CountBits(*Cells) : 0;
 }
 
 void UMergeSubsystem::SpendItems(const FMergeFieldItem& Item, int32 Count)
@@ -461,21 +732,18 @@ void UMergeSubsystem::SpendItems(const FMergeFieldItem& Item, int32 Count)
 	if (Count == 0)
 		return;
 
-	for (auto& Row : MergeField)
+	const uint64* Cells = UsableItemCells.Find(GetItemKey(Item));
+
+	if (!Cells)
+		return;
+
+	// copy, the map entry changes while cells are cleared
+	for (uint64 Mask = *Cells; Mask; Mask &= Mask - 1)
 	{
-		for (auto& RowItem : Row)
-		{
-			if (RowItem.IsDusty || RowItem.IsInBox)
-				continue;
-			
-			if (Item == RowItem)
-			{
-				RowItem.Type = EMergeItemType::None;
-				Count--;
+		WriteCell(FMath::CountTrailingZeros64(Mask), FMergeFieldItem());
+		Count--;
 
-				if (Count == 0)
-					return;
-			}
-		}
+		if (Count == 0)
+			return;
 	}
 }
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MergeSystem/SpawnItemsSampler.h"
+#include "MergeSystem/MergeSubsystem.h"
+
+void FSpawnItemsSampler::Build(const TArray<FSpawnItemData>& InItems)
+{
+	Items = nullptr;
+	Probabilities.Reset();
+	Aliases.Reset();
+
+	const int32 Num = InItems.Num();
+
+	if (Num == 0)
+		return;
+
+	// items count of every probability type
+	TMap<ESpawnProbability, int32> TypeItemsNum;
+	for (const auto& Item : InItems)
+	{
+		TypeItemsNum.FindOrAdd(Item.Probability)++;
+	}
+
+	int32 WeightSum = 0;
+	for (const auto& TypeNum : TypeItemsNum)
+	{
+		WeightSum += UMergeSubsystem::GetWeightForProbability(TypeNum.Key);
+	}
+
+	if (WeightSum <= 0)
+		return;
+
+	// probabilities scaled so that average is 1
+	TArray<float> Scaled;
+	Scaled.SetNumUninitialized(Num);
+
+	TArray<int32> Small, Large;
+	Small.Reserve(Num);
+	Large.Reserve(Num);
+
+	for (int32 i = 0; i < Num; i++)
+	{
+		const ESpawnProbability Probability = InItems[i].Probability;
+		const float Weight = (float)UMergeSubsystem::GetWeightForProbability(Probability) / TypeItemsNum[Probability];
+
+		Scaled[i] = Weight * Num / WeightSum;
+
+		if (Scaled[i] < 1.0f)
+			Small.Add(i);
+		else
+			Large.Add(i);
+	}
+
+	Probabilities.SetNumZeroed(Num);
+	Aliases.SetNumZeroed(Num);
+
+	while (Small.Num() > 0 && Large.Num() > 0)
+	{
+		const int32 Less = Small.Pop(false);
+		const int32 More = Large.Pop(false);
+
+		Probabilities[Less] = Scaled[Less];
+		Aliases[Less] = More;
+
+		Scaled[More] = (Scaled[More] + Scaled[Less]) - 1.0f;
+
+		if (Scaled[More] < 1.0f)
+			Small.Add(More);
+		else
+			Large.Add(More);
+	}
+
+	// rest of columns are full up to float precision
+	for (int32 i : Large)
+	{
+		Probabilities[i] = 1.0f;
+		Aliases[i] = i;
+	}
+
+	for (int32 i : Small)
+	{
+		Probabilities[i] = 1.0f;
+		Aliases[i] = i;
+	}
+
+	Items = &InItems;
+}
+
+const FSpawnItemData& FSpawnItemsSampler::Sample(const FRandomStream* Stream) const
+{
+	check(!IsEmpty());
+
+	const int32 Num = Probabilities.Num();
+
+	const float Random = (Stream ? Stream->GetFraction() : FMath::FRand()) * Num;
+	const int32 Column = FMath::Min((int32)Random, Num - 1);
+
+	const int32 ItemIndex = (Random - Column) < Probabilities[Column] ? Column : Aliases[Column];
+
+	return (*Items)[ItemIndex];
+}
@@ -3,7 +3,7 @@
 
 #include "QuestSystem/MBQuestSubsystem.h"
 
-#include "JsonObjectConverter.h"
+#include "Utilities/MBJsonCodec.h"
 #include "MBUtilityFunctionLibrary.h"
 #include "TimeSubsystem.h"
 #include "Analytics/FGAnalytics.h"
@@ -20,8 +20,20 @@ void UMBQuestSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
 
+	// quests are bound to city objects and refreshed by server time
+	Collection.InitializeDependency(UCityBuilderSubsystem::StaticClass());
+	Collection.InitializeDependency(UTimeSubsystem::StaticClass());
+
 	FTimerDelegate Delegate = FTimerDelegate::CreateLambda([this]() {
 		auto TimeSystem = GetGameInstance()->GetSubsystem<UTimeSubsystem>();
+
+		// time can be already known from the trusted offset
+		if (TimeSystem->IsTimeValid())
+		{
+			InitQuests();
+			return;
+		}
+
 		OnGetTimeDelegateHandle = TimeSystem->OnTimeSuccessRequested.AddUObject(this, &UMBQuestSubsystem::InitQuests);
 	});
 
@@ -39,24 +51,41 @@ void UMBQuestSubsystem::SaveQuests()
 {
 	if (!IsInitialized)
 		return;
-	
-	TSharedPtr<FJsonObject> JsonObject = MakeShared<FJsonObject>();
-
-	TArray<TSharedPtr<FJsonValue>> QuestsArray;
 
-	for (const auto& Quest : Quests)
+	UMBUtilityFunctionLibrary::SaveBinaryToStorage("Quests", QuestsStorageVersion, [this](FArchive& Ar, int32 Version)
 	{
-		TSharedPtr<FJsonObject> JsonQuest = FJsonObjectConverter::UStructToJsonObject<FQuestData>(Quest);
-		TSharedPtr<FJsonValueObject> QuestValue = MakeShared<FJsonValueObject>(JsonQuest);
+		SerializeQuests(Ar, Version);
+	});
 
-		QuestsArray.Add(QuestValue);
+	if (UMBUtilityFunctionLibrary::IsJsonExportEnabled())
+	{
+		ExportQuestsJson();
 	}
+}
 
-	JsonObject->SetArrayField("Quests", QuestsArray);
-	JsonObject->SetStringField("DateTo", DateTo.ToIso8601());
+void UMBQuestSubsystem::SerializeQuests(FArchive& Ar, int32 Version)
+{
+	SerializeStructArray(Ar, Quests);
+	Ar << DateTo;
+}
 
+void UMBQuestSubsystem::ExportQuestsJson()
+{
 	FString StringData;
-	UMBUtilityFunctionLibrary::JsonObjectToString(JsonObject, StringData);
+	auto Writer = FMBJsonCodec::CreateWriter(StringData);
+
+	Writer->WriteObjectStart();
+	Writer->WriteArrayStart("Quests");
+
+	for (const auto& Quest : Quests)
+	{
+		FMBJsonCodec::WriteStruct(*Writer, Quest);
+	}
+
+	Writer->WriteArrayEnd();
+	Writer->WriteValue("DateTo", DateTo.ToIso8601());
+	Writer->WriteObjectEnd();
+	Writer->Close();
 
 	UMBUtilityFunctionLibrary::SaveToStorage("Quests", StringData);
 }
@@ -117,14 +146,13 @@ void UMBQuestSubsystem::CompleteQuest(const FString& QuestID)
 		}
 	}
 	
-	for (const auto& RewardItem : Quest.RewardItems)
-	{
-		MergeSubsystem->AddNewReward(RewardItem);
-	}
+	FRewardGrant Grant;
+	Grant.Experience = Quest.RewardExperience;
+	Grant.Items = Quest.RewardItems;
 
 	auto AccountSubsystem = GetGameInstance()->GetSubsystem<UAccountSubsystem>();
 
-	AccountSubsystem->AddExperience(Quest.RewardExperience);
+	AccountSubsystem->GrantRewards(Grant);
 
 	if (GenerateNewQuestAfterComplete)
 	{
@@ -152,51 +180,63 @@ TArray<FString> UMBQuestSubsystem::GetAllQuestIDs()
 
 void UMBQuestSubsystem::InitQuests()
 {
+	const bool BinaryLoaded = UMBUtilityFunctionLibrary::ReadBinaryFromStorage("Quests", [this](FArchive& Ar, int32 Version)
+	{
+		SerializeQuests(Ar, Version);
+	});
+
 	FString SavedData;
-	if (UMBUtilityFunctionLibrary::ReadFromStorage("Quests", SavedData))
+	if (!BinaryLoaded && UMBUtilityFunctionLibrary::ReadFromStorage("Quests", SavedData))
 	{
+		// migrate quests from json storage
 		ParseQuests(SavedData);
 	}
 
-	CheckRefreshQuestsTimer();
+	CheckRefreshQuests();
+	ScheduleQuestsRefresh();
 	
 	IsInitialized = true;
 
+	if (!BinaryLoaded)
+	{
+		SaveQuests();
+	}
+
 	auto CityBuilderSubsystem = GetGameInstance()->GetSubsystem<UCityBuilderSubsystem>();
 	
 	CityBuilderSubsystem->SetNewQuestsForObjects(GetAllQuestIDs());
 
 	CityBuilderSubsystem->OnBuildNewObject.AddDynamic(this, &UMBQuestSubsystem::UpdateCityObjectBuildQuests);
 
-	GetWorld()->GetTimerManager().SetTimer(QuestRefreshTimerHandle, this, &UMBQuestSubsystem::CheckRefreshQuestsTimer, 1.0f, true);
-
 	auto TimeSubsystem = GetGameInstance()->GetSubsystem<UTimeSubsystem>();
 	TimeSubsystem->OnTimeSuccessRequested.Remove(OnGetTimeDelegateHandle);
 }
 
 void UMBQuestSubsystem::ParseQuests(const FString& JsonString)
 {
-	TSharedPtr<FJsonObject> JsonObject;
+	auto Reader = FMBJsonCodec::CreateReader(JsonString);
 
-	if (!UMBUtilityFunctionLibrary::StringToJsonObject(JsonString, JsonObject))
+	EJsonNotation Notation;
+	if (!Reader->ReadNext(Notation) || Notation != EJsonNotation::ObjectStart)
 		return;
 
 	Quests.Empty();
-	
-	const TArray<TSharedPtr<FJsonValue>>* QuestsArray;
-	if (JsonObject->TryGetArrayField("Quests", QuestsArray))
+
+	while (Reader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
 	{
-		for (const auto& QuestValue : *QuestsArray)
+		if (Reader->GetIdentifier() == "Quests" && Notation == EJsonNotation::ArrayStart)
 		{
-			FQuestData Quest;
-			if (!FJsonObjectConverter::JsonObjectToUStruct<FQuestData>(QuestValue->AsObject().ToSharedRef(), &Quest))
-				continue;
-		
-			Quests.Add(Quest);
+			FMBJsonCodec::ReadStructArray(*Reader, Quests);
+		}
+		else if (Reader->GetIdentifier() == "DateTo" && Notation == EJsonNotation::String)
+		{
+			FDateTime::ParseIso8601(*Reader->GetValueAsString(), DateTo);
+		}
+		else
+		{
+			FMBJsonCodec::SkipValue(*Reader, Notation);
 		}
 	}
-
-	FDateTime::ParseIso8601(*(JsonObject->GetStringField("DateTo")), DateTo);
 }
 
 void UMBQuestSubsystem::GenerateNewQuests()
@@ -223,6 +263,8 @@ void UMBQuestSubsystem::GenerateNewQuests()
 	auto TimeSystem = GetGameInstance()->GetSubsystem<UTimeSubsystem>();
 	
 	DateTo = TimeSystem->GetUTCNow() + FTimespan::FromHours(RefreshHours);
+
+	ScheduleQuestsRefresh();
 }
 
 void UMBQuestSubsystem::GenerateNewQuest(FQuestData& NewQuest)
@@ -336,7 +378,7 @@ void UMBQuestSubsystem::GenerateRequiredMergeItemsForQuest(TArray<FRequiredItem>
 
 void UMBQuestSubsystem::GenerateRequiredCityObjectForQuest(FName& RequiredObjectName, int32& RequiredObjectAmount)
 {
-	TMap<FName, FCityObjectData*> QuestObjects;
+	TMap<FName, const FCityObjectData*> QuestObjects;
 	GetQuestObjects(QuestObjects);
 
 	int32 RandomIndex = UKismetMathLibrary::RandomIntegerInRange(0, QuestObjects.Num() - 1);
@@ -370,7 +412,7 @@ void UMBQuestSubsystem::GenerateRewardForCityObject(const FName& RequiredObjectN
 {
 	auto CitySubsystem = GetGameInstance()->GetSubsystem<UCityBuilderSubsystem>();
 
-	const FCityObjectData* RowStruct = CitySubsystem->CityObjectsDataTable->FindRow<FCityObjectData>(RequiredObjectName, "");
+	const FCityObjectData* RowStruct = CitySubsystem->GetObjectsIndex().FindRow(RequiredObjectName);
 
 	int32 QuestHardness = CalculateHardnessOfRequiredObjects(RowStruct->RequiredItems);
 
@@ -417,10 +459,7 @@ void UMBQuestSubsystem::GenerateMergeItemForQuest(EMergeItemType ItemType, FRequ
 
 	OutItem.Item.Type = ItemType;
 	
-	FString RowName = UMBUtilityFunctionLibrary::EnumToString("EMergeItemType", (int32)ItemType);
-
-	const FMergeItemChainRow* RowStruct = MergeSubsystem->MergeItemsDataTable->FindRow<FMergeItemChainRow>(FName(RowName), "");
-	int32 ItemMaxLevel = RowStruct->ItemsChain.Num();
+	int32 ItemMaxLevel = MergeSubsystem->GetItemMaxLevel(ItemType);
 	
 	OutItem.Item.Level = UKismetMathLibrary::RandomIntegerInRange(1, ItemMaxLevel - 1);
 	OutItem.RequiredNum = UKismetMathLibrary::RandomIntegerInRange(1, ItemMaxLevel - OutItem.Item.Level);
@@ -519,10 +558,7 @@ int32 UMBQuestSubsystem::CalculateHardnessOfRequiredObjects(const TArray<FRequir
 
 	for (const auto& RequiredItem : RequiredItems)
 	{
-		FString RowName = UMBUtilityFunctionLibrary::EnumToString("EMergeItemType", (int32)RequiredItem.Item.Type);
-		const FMergeItemChainRow* RowStruct = MergeSubsystem->MergeItemsDataTable->FindRow<FMergeItemChainRow>(FName(RowName), "");
-
-		int32 ItemCost = RowStruct->ItemsChain[RequiredItem.Item.Level-1].SellPrice;
+		int32 ItemCost = MergeSubsystem->GetItemData(RequiredItem.Item)->SellPrice;
 
 		ItemCost *= RequiredItem.RequiredNum;
 
@@ -546,11 +582,15 @@ void UMBQuestSubsystem::UpdateCityObjectBuildQuests(FName NewBuildObject)
 	UpdateQuests();
 }
 
-void UMBQuestSubsystem::CheckRefreshQuestsTimer()
+void UMBQuestSubsystem::CheckRefreshQuests()
 {
 	auto TimeSystem = GetGameInstance()->GetSubsystem<UTimeSubsystem>();
+
+	// refresh deadline calls it again when server confirms the time
+	if (!TimeSystem->IsTimeVerified())
+		return;
 	
-	if (TimeSystem->GetUTCNow() > DateTo)
+	if (TimeSystem->GetUTCNow() >= DateTo)
 	{
 		GenerateNewQuests();
 
@@ -558,6 +598,14 @@ void UMBQuestSubsystem::CheckRefreshQuestsTimer()
 	}
 }
 
+void UMBQuestSubsystem::ScheduleQuestsRefresh()
+{
+	auto TimeSystem = GetGameInstance()->GetSubsystem<UTimeSubsystem>();
+
+	TimeSystem->RemoveDeadline(RefreshDeadlineID);
+	RefreshDeadlineID = TimeSystem->AddDeadline(DateTo, FSimpleDelegate::CreateUObject(this, &UMBQuestSubsystem::CheckRefreshQuests));
+}
+
 void UMBQuestSubsystem::GetPossibleItemTypes(TArray<EMergeItemType>& OutItemTypes)
 {
 	auto CitySubsystem = GetGameInstance()->GetSubsystem<UCityBuilderSubsystem>();
@@ -608,26 +656,24 @@ void UMBQuestSubsystem::HandleSuccessWatchVideoForQuests()
 
 	DateTo -= SkipTime;
 
-	CheckRefreshQuestsTimer();
+	ScheduleQuestsRefresh();
+	CheckRefreshQuests();
 
 	SaveQuests();
 }
 
-void UMBQuestSubsystem::GetQuestObjects(TMap<FName, FCityObjectData*>& OutObjects)
+void UMBQuestSubsystem::GetQuestObjects(TMap<FName, const FCityObjectData*>& OutObjects)
 {
 	auto CityBuilderSubsystem = GetGameInstance()->GetSubsystem<UCityBuilderSubsystem>();
 	
-	TMap<FName, uint8*> RowsMap = CityBuilderSubsystem->CityObjectsDataTable->GetRowMap();
+	const FCityObjectsIndex& ObjectsIndex = CityBuilderSubsystem->GetObjectsIndex();
 
 	TArray<EMergeItemType> PossibleItemTypes;
 	GetPossibleItemTypes(PossibleItemTypes);
 
-	for (const auto& Row : RowsMap)
+	for (const auto& ObjectName : ObjectsIndex.GetQuestObjects())
 	{
-		auto RowData = (FCityObjectData*)Row.Value;
-
-		if (!RowData->FitForQuest)
-			continue;
+		auto RowData = ObjectsIndex.FindRow(ObjectName);
 
 		bool IsPossible = true;
 		for (const auto& Item : RowData->RequiredItems)
@@ -642,6 +688,6 @@ void UMBQuestSubsystem::GetQuestObjects(TMap<FName, FCityObjectData*>& OutObject
 		if (!IsPossible)
 			continue;
 		
-		OutObjects.Add(Row.Key, RowData);
+		OutObjects.Add(ObjectName, RowData);
 	}
 }
@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "JsonObjectConverter.h"
+#include "Utilities/MBJsonCodec.h"
+#include "MBUtilityFunctionLibrary.h"
+#include "CitySystem/CityObjectsData.h"
+#include "QuestSystem/MBQuest.h"
+#include "ShopSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	template <typename TStruct>
+	FString WriteWithConverter(const TStruct& Struct)
+	{
+		TSharedRef<FJsonObject> JsonObject = MakeShared<FJsonObject>();
+		FJsonObjectConverter::UStructToJsonObject(TStruct::StaticStruct(), &Struct, JsonObject, 0, 0);
+
+		FString StringData;
+		FJsonSerializer::Serialize(JsonObject, FMBJsonCodec::CreateWriter(StringData));
+
+		return StringData;
+	}
+
+	template <typename TStruct>
+	FString WriteWithCodec(const TStruct& Struct)
+	{
+		FString StringData;
+		auto Writer = FMBJsonCodec::CreateWriter(StringData);
+
+		FMBJsonCodec::WriteStruct(*Writer, Struct);
+		Writer->Close();
+
+		return StringData;
+	}
+
+	// storage file bytes of the string written by the engine file helper
+	TArray<uint8> SaveWithFileHelper(const FString& Data)
+	{
+		const FString FilePath = FPaths::CreateTempFilename(*FPaths::ProjectSavedDir(), TEXT("JsonCodecTest"), TEXT(".json"));
+
+		TArray<uint8> FileData;
+		FFileHelper::SaveStringToFile(Data, *FilePath);
+		FFileHelper::LoadFileToArray(FileData, *FilePath);
+
+		IFileManager::Get().Delete(*FilePath);
+
+		return FileData;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMBJsonCodecOutputTest, "MergeBuilder.Storage.JsonCodecOutput",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMBJsonCodecOutputTest::RunTest(const FString& Parameters)
+{
+	FCityObject CityObject;
+	CityObject.ObjectName = FName("Mine2");
+	CityObject.Location = FVector(1250.5f, -340.25f, 0.1f);
+	CityObject.Rotation = 33.3f;
+	CityObject.Scale = 1.0f;
+	CityObject.RestoreTime = FDateTime(2024, 3, 15, 8, 30, 45, 125);
+	CityObject.QuestID = TEXT("quest_12");
+	CityObject.ObjectID = 7;
+
+	FMergeFieldItem Item;
+	Item.Type = EMergeItemType::EnergyBox;
+	Item.Level = 3;
+	Item.RemainItemsToSpawn = 2;
+	Item.IsDusty = true;
+
+	FRequiredItem RequiredItem;
+	RequiredItem.Item = Item;
+	RequiredItem.RequiredNum = 4;
+
+	FQuestData QuestData;
+	QuestData.QuestID = TEXT("quest_12");
+	QuestData.QuestType = EQuestType::CityObjects;
+	QuestData.RequiredItems.Add(RequiredItem);
+	QuestData.RequiredObjectName = FName("Mine");
+	QuestData.RequiredObjectAmount = 2;
+	QuestData.RequiredObjectProgress = 1;
+	QuestData.RewardExperience = 35;
+	QuestData.RewardItems.Add(Item);
+
+	FPurchaseHistory PurchaseHistory;
+	PurchaseHistory.ProductID = TEXT("starter_pack");
+	PurchaseHistory.PurchaseLimit = 1;
+	PurchaseHistory.LastPurchaseDate = FDateTime(2024, 3, 14, 23, 59, 59);
+
+	TestEqual(TEXT("FCityObject json"), WriteWithCodec(CityObject), WriteWithConverter(CityObject));
+	TestEqual(TEXT("FQuestData json"), WriteWithCodec(QuestData), WriteWithConverter(QuestData));
+	TestEqual(TEXT("FPurchaseHistory json"), WriteWithCodec(PurchaseHistory), WriteWithConverter(PurchaseHistory));
+
+	// storage files keep the encoding of FFileHelper::SaveStringToFile
+	const FString AnsiData = WriteWithCodec(CityObject);
+	const FString UnicodeData = AnsiData + TEXT("\u0413\u043E\u0440\u043E\u0434");
+
+	for (const FString& Data : { AnsiData, UnicodeData })
+	{
+		TArray<uint8> EncodedData;
+		UMBUtilityFunctionLibrary::EncodeStorageString(Data, EncodedData);
+
+		TestTrue(TEXT("Storage file bytes"), EncodedData == SaveWithFileHelper(Data));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMBJsonCodecPartialArrayTest, "MergeBuilder.Storage.JsonCodecPartialArray",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMBJsonCodecPartialArrayTest::RunTest(const FString& Parameters)
+{
+	const FString JsonString = TEXT("[")
+		TEXT("{\"questID\": \"first\", \"questType\": \"MergeItems\", \"rewardExperience\": 10},")
+		TEXT("{\"questID\": \"second\", \"questType\": \"UnknownType\", \"rewardExperience\": 20},")
+		TEXT("{\"questID\": \"third\", \"questType\": \"CityObjects\", \"rewardExperience\": 30}")
+		TEXT("]");
+
+	AddExpectedError(TEXT("is read partly"), EAutomationExpectedErrorFlags::Contains, 1);
+
+	auto Reader = FMBJsonCodec::CreateReader(JsonString);
+
+	EJsonNotation Notation;
+	Reader->ReadNext(Notation);
+
+	TArray<FQuestData> Quests;
+	const bool Result = FMBJsonCodec::ReadStructArray(*Reader, Quests);
+
+	TestFalse(TEXT("Array with bad enum is reported"), Result);
+
+	// struct with the bad field keeps its place, so indexes of the next structs don't shift
+	TestEqual(TEXT("Quests count"), Quests.Num(), 3);
+
+	if (Quests.Num() == 3)
+	{
+		TestEqual(TEXT("Partly read quest id"), Quests[1].QuestID, FString(TEXT("second")));
+		TestEqual(TEXT("Partly read quest reward"), Quests[1].RewardExperience, 20);
+		TestEqual(TEXT("Next quest id"), Quests[2].QuestID, FString(TEXT("third")));
+		TestTrue(TEXT("Next quest type"), Quests[2].QuestType == EQuestType::CityObjects);
+	}
+
+	return true;
+}
+
+#endif
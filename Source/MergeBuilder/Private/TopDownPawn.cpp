@@ -27,6 +27,17 @@ void ATopDownPawn::BeginPlay()
 	
 }
 
+AMBCityBuilderManager* ATopDownPawn::GetCityManager()
+{
+	// manager lives as long as the level, it's found once
+	if (!CityBuilderManager)
+	{
+		CityBuilderManager = Cast<AMBCityBuilderManager>(UGameplayStatics::GetActorOfClass(GetWorld(), AMBCityBuilderManager::StaticClass()));
+	}
+
+	return CityBuilderManager;
+}
+
 void ATopDownPawn::TouchPress(const ETouchIndex::Type FingerIndex, const FVector Location)
 {
 	AMBBasePawn::TouchPress(FingerIndex, Location);
@@ -41,7 +52,7 @@ void ATopDownPawn::TouchPress(const ETouchIndex::Type FingerIndex, const FVector
 		TArray<FHitResult> HitResults;
 		if (GetMultiWorldObjectHitResults(FingerIndex, HitResults))
 		{
-			auto CityManager = Cast<AMBCityBuilderManager>(UGameplayStatics::GetActorOfClass(GetWorld(), AMBCityBuilderManager::StaticClass()));
+			auto CityManager = GetCityManager();
 
 			for (auto& HitResult : HitResults)
 			{
@@ -74,7 +85,7 @@ void ATopDownPawn::TouchRelease(const ETouchIndex::Type FingerIndex, const FVect
 	{
 		if (DragItem)
 		{
-			auto CityManager = Cast<AMBCityBuilderManager>(UGameplayStatics::GetActorOfClass(GetWorld(), AMBCityBuilderManager::StaticClass()));
+			auto CityManager = GetCityManager();
 			CityManager->HandleDragRelease();
 		}
 		
@@ -115,7 +126,7 @@ void ATopDownPawn::TouchMove(const ETouchIndex::Type FingerIndex, const FVector
 	{
 		if (DragItem)
 		{
-			auto CityManager = Cast<AMBCityBuilderManager>(UGameplayStatics::GetActorOfClass(GetWorld(), AMBCityBuilderManager::StaticClass()));
+			auto CityManager = GetCityManager();
 			FHitResult HitResult;
 			if (GetInputHitResult(FingerIndex, HitResult))
 			{
@@ -199,7 +210,7 @@ void ATopDownPawn::OnClick(const FVector Location)
 {
 	AMBBasePawn::OnClick(Location);
 
-	auto CityManager = Cast<AMBCityBuilderManager>(UGameplayStatics::GetActorOfClass(GetWorld(), AMBCityBuilderManager::StaticClass()));
+	auto CityManager = GetCityManager();
 	FHitResult HitResult;
 	if (GetWorldObjectHitResult(ETouchIndex::Touch1, HitResult))
 	{
@@ -5,6 +5,7 @@
 
 #include "MBGameInstance.h"
 #include "MBUtilityFunctionLibrary.h"
+#include "Utilities/MBJsonCodec.h"
 #include "Analytics/FGAnalytics.h"
 #include "CitySystem/CityBuilderSubsystem.h"
 #include "CitySystem/CityObjectsData.h"
@@ -21,10 +22,21 @@ UMBTutorialSubsystem::~UMBTutorialSubsystem()
 
 void UMBTutorialSubsystem::Init()
 {
+	const bool BinaryLoaded = UMBUtilityFunctionLibrary::ReadBinaryFromStorage("TutorialProgress", [this](FArchive& Ar, int32 Version)
+	{
+		SerializeProgress(Ar, Version);
+	});
+
 	FString SavedData;
-	if (UMBUtilityFunctionLibrary::ReadFromStorage("TutorialProgress", SavedData))
+	if (BinaryLoaded || UMBUtilityFunctionLibrary::ReadFromStorage("TutorialProgress", SavedData))
 	{
-		ParseProgress(SavedData);
+		// migrate progress from json storage
+		if (!BinaryLoaded)
+		{
+			ParseProgress(SavedData);
+			SaveProgress();
+		}
+
 		if (TutorialStep > 0 && !bIsTutorialFinished)
 		{
 			bIsTutorialFinished = true;
@@ -52,26 +64,53 @@ bool UMBTutorialSubsystem::IsTutorialFinished() const
 
 bool UMBTutorialSubsystem::ParseProgress(const FString& JsonString)
 {
-	TSharedPtr<FJsonObject> JsonObject;
+	auto Reader = FMBJsonCodec::CreateReader(JsonString);
 
-	if (!UMBUtilityFunctionLibrary::StringToJsonObject(JsonString, JsonObject))
+	EJsonNotation Notation;
+	if (!Reader->ReadNext(Notation) || Notation != EJsonNotation::ObjectStart)
 		return false;
 
-	JsonObject->TryGetNumberField("TutorialStep", TutorialStep);
-	JsonObject->TryGetBoolField("IsTutorialFinished", bIsTutorialFinished);
+	while (Reader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
+	{
+		if (Reader->GetIdentifier() == "TutorialStep")
+			TutorialStep = FMBJsonCodec::GetValueAsNumber(*Reader, Notation);
+		else if (Reader->GetIdentifier() == "IsTutorialFinished")
+			bIsTutorialFinished = FMBJsonCodec::GetValueAsBool(*Reader, Notation);
+		else
+			FMBJsonCodec::SkipValue(*Reader, Notation);
+	}
 
-	return true;
+	return Notation == EJsonNotation::ObjectEnd;
 }
 
 void UMBTutorialSubsystem::SaveProgress()
 {
-	TSharedPtr<FJsonObject> JsonObject = MakeShared<FJsonObject>();
+	UMBUtilityFunctionLibrary::SaveBinaryToStorage("TutorialProgress", TutorialStorageVersion, [this](FArchive& Ar, int32 Version)
+	{
+		SerializeProgress(Ar, Version);
+	});
 
-	JsonObject->SetNumberField("TutorialStep", TutorialStep);
-	JsonObject->SetBoolField("IsTutorialFinished", bIsTutorialFinished);
-	
+	if (UMBUtilityFunctionLibrary::IsJsonExportEnabled())
+	{
+		ExportProgressJson();
+	}
+}
+
+void UMBTutorialSubsystem::SerializeProgress(FArchive& Ar, int32 Version)
+{
+	Ar << TutorialStep << bIsTutorialFinished;
+}
+
+void UMBTutorialSubsystem::ExportProgressJson()
+{
 	FString StringData;
-	UMBUtilityFunctionLibrary::JsonObjectToString(JsonObject, StringData);
+	auto Writer = FMBJsonCodec::CreateWriter(StringData);
+
+	Writer->WriteObjectStart();
+	Writer->WriteValue("TutorialStep", static_cast<double>(TutorialStep));
+	Writer->WriteValue("IsTutorialFinished", bIsTutorialFinished);
+	Writer->WriteObjectEnd();
+	Writer->Close();
 
 	UMBUtilityFunctionLibrary::SaveToStorage("TutorialProgress", StringData);
 }
@@ -3,6 +3,7 @@
 
 #include "User/AccountSubsystem.h"
 #include "MBUtilityFunctionLibrary.h"
+#include "Utilities/MBJsonCodec.h"
 #include "TimeSubsystem.h"
 #include "Analytics/FGAnalytics.h"
 
@@ -23,8 +24,19 @@ UAccountSubsystem::UAccountSubsystem()
 
 void UAccountSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
+	// energy is restored by server time
+	Collection.InitializeDependency(UTimeSubsystem::StaticClass());
+
 	FTimerDelegate Delegate = FTimerDelegate::CreateLambda([this]() {
 		auto TimeSystem = GetGameInstance()->GetSubsystem<UTimeSubsystem>();
+
+		// time can be already known from the trusted offset
+		if (TimeSystem->IsTimeValid())
+		{
+			InitAccount();
+			return;
+		}
+
 		OnGetTimeDelegateHandle = TimeSystem->OnTimeSuccessRequested.AddUObject(this, &UAccountSubsystem::InitAccount);
 	});
 
@@ -33,6 +45,12 @@ void UAccountSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 
 void UAccountSubsystem::Deinitialize()
 {
+	if (EnergyDeadlineID != INDEX_NONE)
+	{
+		GetGameInstance()->GetSubsystem<UTimeSubsystem>()->RemoveDeadline(EnergyDeadlineID);
+		EnergyDeadlineID = INDEX_NONE;
+	}
+
 	SaveAccount();
 }
 
@@ -40,125 +58,218 @@ void UAccountSubsystem::SaveAccount()
 {
 	if (!IsInitialized)
 		return;
-	
-	TSharedPtr<FJsonObject> JsonObject = MakeShared<FJsonObject>();
-
-	JsonObject->SetNumberField("level", Level);
-	JsonObject->SetNumberField("exp", Experience);
-	JsonObject->SetNumberField("softCoins", SoftCoins);
-	JsonObject->SetNumberField("premCoins", PremCoins);
-	JsonObject->SetNumberField("energy", Energy);
-	JsonObject->SetNumberField("maxEnergy", MaxEnergy);
-	JsonObject->SetBoolField("infiniteEnergy", InfiniteEnergy);
-	if (Energy < MaxEnergy)
+
+	UMBUtilityFunctionLibrary::SaveBinaryToStorage("Account", AccountStorageVersion, [this](FArchive& Ar, int32 Version)
 	{
-		float RemainRestoreTime = GetWorld()->GetTimerManager().GetTimerRemaining(EnergyRestoreTimerHandle);
-		JsonObject->SetNumberField("remainRestoreEnergySeconds", RemainRestoreTime);
+		SerializeAccount(Ar, Version);
+	});
+
+	if (UMBUtilityFunctionLibrary::IsJsonExportEnabled())
+	{
+		ExportAccountJson();
 	}
+}
 
-	auto TimeSystem = GetGameInstance()->GetSubsystem<UTimeSubsystem>();
-	FDateTime SaveTime = TimeSystem->IsTimeValid() ? TimeSystem->GetUTCNow() : LastSaveTime;
-	JsonObject->SetStringField("saveTime", SaveTime.ToIso8601());
+void UAccountSubsystem::SerializeAccount(FArchive& Ar, int32 Version)
+{
+	Ar << Level << Experience << SoftCoins << PremCoins << Energy << MaxEnergy << InfiniteEnergy;
+
+	if (Version >= 2)
+	{
+		Ar << EnergyFullTime;
+		return;
+	}
+
+	// version 1 saved remain seconds of the current restore
+	FDateTime SaveTime;
+	float RemainRestoreEnergySeconds = 0.0f;
+	Ar << SaveTime << RemainRestoreEnergySeconds;
+
+	if (Ar.IsLoading())
+	{
+		InitEnergyFullTime(SaveTime, RemainRestoreEnergySeconds);
+	}
+}
 
+void UAccountSubsystem::ExportAccountJson()
+{
 	FString StringData;
-	UMBUtilityFunctionLibrary::JsonObjectToString(JsonObject, StringData);
+	auto Writer = FMBJsonCodec::CreateWriter(StringData);
+
+	Writer->WriteObjectStart();
+	Writer->WriteValue("level", static_cast<double>(Level));
+	Writer->WriteValue("exp", static_cast<double>(Experience));
+	Writer->WriteValue("softCoins", static_cast<double>(SoftCoins));
+	Writer->WriteValue("premCoins", static_cast<double>(PremCoins));
+	Writer->WriteValue("energy", static_cast<double>(Energy));
+	Writer->WriteValue("maxEnergy", static_cast<double>(MaxEnergy));
+	Writer->WriteValue("infiniteEnergy", InfiniteEnergy);
+	if (Energy < MaxEnergy)
+	{
+		Writer->WriteValue("energyFullTime", EnergyFullTime.ToIso8601());
+	}
+
+	Writer->WriteObjectEnd();
+	Writer->Close();
 
 	UMBUtilityFunctionLibrary::SaveToStorage("Account", StringData);
 }
 
 void UAccountSubsystem::ParseAccount(const FString& JsonString)
 {
-	TSharedPtr<FJsonObject> JsonObject;
+	auto Reader = FMBJsonCodec::CreateReader(JsonString);
 
-	if (!UMBUtilityFunctionLibrary::StringToJsonObject(JsonString, JsonObject))
+	EJsonNotation Notation;
+	if (!Reader->ReadNext(Notation) || Notation != EJsonNotation::ObjectStart)
 		return;
 
-	Level = JsonObject->GetNumberField("level");
-	Experience = JsonObject->GetNumberField("exp");
-	SoftCoins = JsonObject->GetNumberField("softCoins");
-	PremCoins = JsonObject->GetNumberField("premCoins");
-	MaxEnergy = JsonObject->GetNumberField("maxEnergy");
-	InfiniteEnergy = JsonObject->GetBoolField("infiniteEnergy");
-	int32 OldEnergy = JsonObject->GetNumberField("Energy");
-
-	FString SaveTimeString;
-	JsonObject->TryGetStringField("saveTime", SaveTimeString);
-	FDateTime::ParseIso8601(*SaveTimeString, LastSaveTime);
-
+	FDateTime SaveTime;
 	double RemainTimeSeconds = SecondsToRestoreEnergy;
-	JsonObject->TryGetNumberField("remainRestoreEnergySeconds", RemainTimeSeconds);
+	bool HasFullTime = false;
 
-	InitEnergy(OldEnergy, LastSaveTime, RemainTimeSeconds);
+	while (Reader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
+	{
+		// identifiers are compared case insensitive
+		const FString& Identifier = Reader->GetIdentifier();
+
+		if (Identifier == "level")
+			Level = FMBJsonCodec::GetValueAsNumber(*Reader, Notation);
+		else if (Identifier == "exp")
+			Experience = FMBJsonCodec::GetValueAsNumber(*Reader, Notation);
+		else if (Identifier == "softCoins")
+			SoftCoins = FMBJsonCodec::GetValueAsNumber(*Reader, Notation);
+		else if (Identifier == "premCoins")
+			PremCoins = FMBJsonCodec::GetValueAsNumber(*Reader, Notation);
+		else if (Identifier == "maxEnergy")
+			MaxEnergy = FMBJsonCodec::GetValueAsNumber(*Reader, Notation);
+		else if (Identifier == "infiniteEnergy")
+			InfiniteEnergy = FMBJsonCodec::GetValueAsBool(*Reader, Notation);
+		else if (Identifier == "energy")
+			Energy = FMBJsonCodec::GetValueAsNumber(*Reader, Notation);
+		else if (Identifier == "energyFullTime")
+			HasFullTime = FDateTime::ParseIso8601(*FMBJsonCodec::GetValueAsString(*Reader, Notation), EnergyFullTime);
+		else if (Identifier == "saveTime")
+			FDateTime::ParseIso8601(*FMBJsonCodec::GetValueAsString(*Reader, Notation), SaveTime);
+		else if (Identifier == "remainRestoreEnergySeconds")
+			RemainTimeSeconds = FMBJsonCodec::GetValueAsNumber(*Reader, Notation);
+		else
+			FMBJsonCodec::SkipValue(*Reader, Notation);
+	}
+
+	// old saves kept remain seconds of the current restore
+	if (!HasFullTime)
+	{
+		InitEnergyFullTime(SaveTime, RemainTimeSeconds);
+	}
 }
 
 void UAccountSubsystem::InitAccount()
 {
-	FString SavedData;
-	if (UMBUtilityFunctionLibrary::ReadFromStorage("Account", SavedData))
+	const bool BinaryLoaded = UMBUtilityFunctionLibrary::ReadBinaryFromStorage("Account", [this](FArchive& Ar, int32 Version)
 	{
-		ParseAccount(SavedData);
-	}
-	else
+		SerializeAccount(Ar, Version);
+	});
+
+	FString SavedData;
+	if (!BinaryLoaded)
 	{
-		Energy = MaxEnergy;
-		SoftCoins = 500;
-		PremCoins = 50;
+		if (UMBUtilityFunctionLibrary::ReadFromStorage("Account", SavedData))
+		{
+			// migrate account from json storage
+			ParseAccount(SavedData);
+		}
+		else
+		{
+			Energy = MaxEnergy;
+			SoftCoins = 500;
+			PremCoins = 50;
+		}
 	}
 
 	MaxExperience = GetMaxExperienceForLevel(Level);
 
 	IsInitialized = true;
+
+	// energy restored while the game was closed is applied without the restore event
+	Energy = GetEnergy();
+	ScheduleEnergyRestore();
+
+	if (!BinaryLoaded)
+	{
+		SaveAccount();
+	}
 }
 
-void UAccountSubsystem::InitEnergy(int32 OldEnergy, FDateTime OldTime, float OldRemainTime)
+void UAccountSubsystem::InitEnergyFullTime(const FDateTime& SaveTime, float RemainRestoreSeconds)
 {
-	auto TimeSystem = GetGameInstance()->GetSubsystem<UTimeSubsystem>();
+	if (Energy >= MaxEnergy)
+		return;
 
-	if (OldEnergy >= MaxEnergy)
-	{
-		Energy = OldEnergy;
+	const float RemainSeconds = RemainRestoreSeconds + (MaxEnergy - Energy - 1) * SecondsToRestoreEnergy;
+	EnergyFullTime = SaveTime + FTimespan::FromSeconds(RemainSeconds);
+}
+
+void UAccountSubsystem::UpdateEnergy()
+{
+	const int32 RestoredEnergy = GetEnergy() - Energy;
+
+	if (RestoredEnergy <= 0)
 		return;
-	}
 
-	float PassedTime = (TimeSystem->GetUTCNow() - OldTime).GetTotalSeconds();
-	PassedTime += (SecondsToRestoreEnergy - OldRemainTime);
-	int32 RestoredEnergy = FMath::TruncToInt(PassedTime / SecondsToRestoreEnergy);
-	int32 NewEnergy = OldEnergy + RestoredEnergy;
+	Energy += RestoredEnergy;
 
-	if (NewEnergy >= MaxEnergy)
+	OnGetEnergy.Broadcast(RestoredEnergy);
+}
+
+void UAccountSubsystem::ScheduleEnergyRestore()
+{
+	auto TimeSystem = GetGameInstance()->GetSubsystem<UTimeSubsystem>();
+
+	if (EnergyDeadlineID != INDEX_NONE)
 	{
-		Energy = MaxEnergy;
-		return;
+		TimeSystem->RemoveDeadline(EnergyDeadlineID);
+		EnergyDeadlineID = INDEX_NONE;
 	}
-	else
+
+	if (!IsInitialized || Energy >= MaxEnergy)
+		return;
+
+	// every unit after the next one takes a whole restore period before full time
+	const FDateTime NextRestoreTime = EnergyFullTime - FTimespan::FromSeconds((MaxEnergy - Energy - 1) * SecondsToRestoreEnergy);
+
+	FSimpleDelegate Callback = FSimpleDelegate::CreateWeakLambda(this, [this]()
 	{
-		Energy = NewEnergy;
-		
-		float RemainTimeToRestore = SecondsToRestoreEnergy - (PassedTime - RestoredEnergy * SecondsToRestoreEnergy);
-		StartRestoreEnergy(RemainTimeToRestore);
-	}
-}
+		EnergyDeadlineID = INDEX_NONE;
 
-int32 UAccountSubsystem::GetMaxExperienceForLevel(int32 InLevel)
-{
-	return InLevel * 50;
+		UpdateEnergy();
+		ScheduleEnergyRestore();
+	});
+
+	EnergyDeadlineID = TimeSystem->AddDeadline(NextRestoreTime, Callback);
 }
 
-void UAccountSubsystem::StartRestoreEnergy(float NextRestoreTime)
+int32 UAccountSubsystem::GetEnergy() const
 {
-	if (Energy >= MaxEnergy)
-		return;
+	// energy above max is not restored, it's only spent
+	if (!IsInitialized || Energy >= MaxEnergy)
+		return Energy;
+
+	auto TimeSystem = GetGameInstance()->GetSubsystem<UTimeSubsystem>();
 
-	FTimerDelegate Delegate = FTimerDelegate::CreateUObject(this, &UAccountSubsystem::RestoreEnergy);
-	GetWorld()->GetTimerManager().SetTimer(EnergyRestoreTimerHandle, Delegate, SecondsToRestoreEnergy, true, NextRestoreTime);
+	// energy is restored only by time confirmed by server, restore deadline applies it after the sync
+	if (!TimeSystem->IsTimeVerified())
+		return Energy;
+
+	// every missing unit of energy takes one restore period before full time
+	const double RemainSeconds = (EnergyFullTime - TimeSystem->GetUTCNow()).GetTotalSeconds();
+	const int32 MissingEnergy = FMath::CeilToInt(FMath::Max(RemainSeconds, 0.0) / SecondsToRestoreEnergy);
+
+	return FMath::Max(Energy, MaxEnergy - MissingEnergy);
 }
 
-void UAccountSubsystem::RestoreEnergy()
+int32 UAccountSubsystem::GetMaxExperienceForLevel(int32 InLevel)
 {
-	if (Energy < MaxEnergy)
-	{
-		AddEnergy(1);
-	}
+	return InLevel * 50;
 }
 
 bool UAccountSubsystem::HasEnoughEnergy(int32 EnergyToSpend)
@@ -166,7 +277,7 @@ bool UAccountSubsystem::HasEnoughEnergy(int32 EnergyToSpend)
 	if (InfiniteEnergy)
 		return true;
 
-	return Energy >= EnergyToSpend;
+	return GetEnergy() >= EnergyToSpend;
 }
 
 bool UAccountSubsystem::SpendEnergy(int32 EnergyToSpend)
@@ -180,10 +291,22 @@ bool UAccountSubsystem::SpendEnergy(int32 EnergyToSpend)
 	if (InfiniteEnergy)
 		return true;
 
+	UpdateEnergy();
+
+	auto TimeSystem = GetGameInstance()->GetSubsystem<UTimeSubsystem>();
+
+	// spent energy is restored after the energy that is already restoring
+	const FDateTime RestoreStartTime = Energy < MaxEnergy ? EnergyFullTime : TimeSystem->GetUTCNow();
+	const int32 EnergyToRestore = FMath::Min(EnergyToSpend, MaxEnergy - (Energy - EnergyToSpend));
+
 	Energy -= EnergyToSpend;
 
-	if (!GetWorld()->GetTimerManager().IsTimerActive(EnergyRestoreTimerHandle))
-		StartRestoreEnergy();
+	if (EnergyToRestore > 0)
+	{
+		EnergyFullTime = RestoreStartTime + FTimespan::FromSeconds(EnergyToRestore * SecondsToRestoreEnergy);
+	}
+
+	ScheduleEnergyRestore();
 
 	SaveAccount();
 
@@ -216,10 +339,16 @@ void UAccountSubsystem::SpendPremCoins(int32 CoinsToSpend)
 
 bool UAccountSubsystem::GetRemainTimeToRestoreEnergy(int32& RemainTimeMinutes, int32& RemainTimeSeconds)
 {
-	if (!GetWorld()->GetTimerManager().IsTimerActive(EnergyRestoreTimerHandle))
+	const int32 CurrentEnergy = GetEnergy();
+
+	if (CurrentEnergy >= MaxEnergy)
 		return false;
 
-	float TotalRemainSeconds = GetWorld()->GetTimerManager().GetTimerRemaining(EnergyRestoreTimerHandle);
+	auto TimeSystem = GetGameInstance()->GetSubsystem<UTimeSubsystem>();
+
+	// the next unit is the last one of the missing energy
+	const double RemainToFullSeconds = (EnergyFullTime - TimeSystem->GetUTCNow()).GetTotalSeconds();
+	float TotalRemainSeconds = RemainToFullSeconds - (MaxEnergy - CurrentEnergy - 1) * SecondsToRestoreEnergy;
 
 	FTimespan RemainTimespan = FTimespan::FromSeconds(TotalRemainSeconds);
 	RemainTimeMinutes = RemainTimespan.GetMinutes();
@@ -230,23 +359,10 @@ bool UAccountSubsystem::GetRemainTimeToRestoreEnergy(int32& RemainTimeMinutes, i
 
 void UAccountSubsystem::AddExperience(int32 DeltaExperience)
 {
-	OnGetExperience.Broadcast(DeltaExperience);
-	
-	int32 RemainDeltaExp = DeltaExperience;
-	while (true)
-	{
-		int32 RemainExperienceToLvlUp = MaxExperience - Experience;
-		if (RemainExperienceToLvlUp > RemainDeltaExp)
-		{
-			Experience += RemainDeltaExp;
-			break;
-		}
+	FRewardGrant Grant;
+	Grant.Experience = DeltaExperience;
 
-		LevelUp();
-		RemainDeltaExp -= RemainExperienceToLvlUp;
-	}
-
-	SaveAccount();
+	GrantRewards(Grant);
 }
 
 void UAccountSubsystem::AddSoftCoins(int32 DeltaCoins)
@@ -254,54 +370,102 @@ void UAccountSubsystem::AddSoftCoins(int32 DeltaCoins)
 	if (DeltaCoins <= 0)
 		return;
 
-	SoftCoins += DeltaCoins;
+	FRewardGrant Grant;
+	Grant.SoftCoins = DeltaCoins;
 
-	OnGetSoftCoins.Broadcast(DeltaCoins);
-
-	SaveAccount();
+	GrantRewards(Grant);
 }
 
 void UAccountSubsystem::AddPremCoins(int32 DeltaCoins)
 {
 	if (DeltaCoins <= 0)
 		return;
-	
-	PremCoins += DeltaCoins;
 
-	OnGetPremCoins.Broadcast(DeltaCoins);
+	FRewardGrant Grant;
+	Grant.PremCoins = DeltaCoins;
 
-	SaveAccount();
+	GrantRewards(Grant);
 }
 
 void UAccountSubsystem::AddEnergy(int32 DeltaEnergy)
 {
-	Energy += DeltaEnergy;
+	if (DeltaEnergy <= 0)
+		return;
+
+	FRewardGrant Grant;
+	Grant.Energy = DeltaEnergy;
+
+	GrantRewards(Grant);
+}
+
+void UAccountSubsystem::GrantRewards(const FRewardGrant& Grant)
+{
+	FRewardGrant AppliedGrant = Grant;
 
-	if (Energy >= MaxEnergy)
+	int32 RemainDeltaExp = Grant.Experience;
+	while (RemainDeltaExp > 0)
 	{
-		GetWorld()->GetTimerManager().ClearTimer(EnergyRestoreTimerHandle);
+		int32 RemainExperienceToLvlUp = MaxExperience - Experience;
+		if (RemainExperienceToLvlUp > RemainDeltaExp)
+		{
+			Experience += RemainDeltaExp;
+			break;
+		}
+
+		LevelUp(AppliedGrant.Items);
+		AppliedGrant.NewLevels++;
+		RemainDeltaExp -= RemainExperienceToLvlUp;
 	}
 
-	OnGetEnergy.Broadcast(DeltaEnergy);
+	SoftCoins += FMath::Max(Grant.SoftCoins, 0);
+	PremCoins += FMath::Max(Grant.PremCoins, 0);
+
+	// energy is taken only with SpendEnergy, which moves the full time
+	if (Grant.Energy > 0)
+	{
+		UpdateEnergy();
+
+		// added energy shortens the restore, progress of the current unit is kept
+		if (Energy < MaxEnergy)
+		{
+			EnergyFullTime -= FTimespan::FromSeconds(Grant.Energy * SecondsToRestoreEnergy);
+		}
+
+		Energy += Grant.Energy;
+
+		ScheduleEnergyRestore();
+	}
+
+	auto MergeSystem = GetGameInstance()->GetSubsystem<UMergeSubsystem>();
+	MergeSystem->AddNewRewards(AppliedGrant.Items);
 
 	SaveAccount();
+
+	if (Grant.Experience > 0)
+		OnGetExperience.Broadcast(Grant.Experience);
+
+	if (AppliedGrant.NewLevels > 0)
+		OnGetNewLevel.Broadcast();
+
+	if (Grant.SoftCoins > 0)
+		OnGetSoftCoins.Broadcast(Grant.SoftCoins);
+
+	if (Grant.PremCoins > 0)
+		OnGetPremCoins.Broadcast(Grant.PremCoins);
+
+	if (Grant.Energy > 0)
+		OnGetEnergy.Broadcast(Grant.Energy);
+
+	OnRewardsGranted.Broadcast(AppliedGrant);
 }
 
-void UAccountSubsystem::LevelUp()
+void UAccountSubsystem::LevelUp(TArray<FMergeFieldItem>& OutRewards)
 {
 	Level++;
 	Experience = 0;
 	MaxExperience = GetMaxExperienceForLevel(Level);
 
-	auto MergeSystem = GetGameInstance()->GetSubsystem<UMergeSubsystem>();
-	for (auto& Reward : LevelRewards)
-	{
-		MergeSystem->AddNewReward(Reward);
-	}
-
-	OnGetNewLevel.Broadcast();
+	OutRewards.Append(LevelRewards);
 
 	UFGAnalytics::LogEvent("new_level" + FString::FromInt(Level));
-
-	SaveAccount();
-}
\ No newline at end of file
+}
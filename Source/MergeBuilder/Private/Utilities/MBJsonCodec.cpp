@@ -0,0 +1,487 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utilities/MBJsonCodec.h"
+#include "JsonObjectConverter.h"
+#include "UObject/TextProperty.h"
+#include "UObject/EnumProperty.h"
+
+namespace
+{
+	template <typename TValue>
+	void WriteValue(FMBJsonWriter& Writer, const FString* Identifier, const TValue& Value)
+	{
+		if (Identifier)
+			Writer.WriteValue(*Identifier, Value);
+		else
+			Writer.WriteValue(Value);
+	}
+
+	void WriteObjectStart(FMBJsonWriter& Writer, const FString* Identifier)
+	{
+		if (Identifier)
+			Writer.WriteObjectStart(*Identifier);
+		else
+			Writer.WriteObjectStart();
+	}
+
+	void WriteArrayStart(FMBJsonWriter& Writer, const FString* Identifier)
+	{
+		if (Identifier)
+			Writer.WriteArrayStart(*Identifier);
+		else
+			Writer.WriteArrayStart();
+	}
+
+	void WriteProperties(FMBJsonWriter& Writer, const UStruct* Struct, const void* Data);
+
+	void WriteScalar(FMBJsonWriter& Writer, const FString* Identifier, FProperty* Property, const void* Value)
+	{
+		if (auto EnumProperty = CastField<FEnumProperty>(Property))
+		{
+			// enums are written as names
+			const int64 EnumValue = EnumProperty->GetUnderlyingProperty()->GetSignedIntPropertyValue(Value);
+			WriteValue(Writer, Identifier, EnumProperty->GetEnum()->GetNameStringByValue(EnumValue));
+		}
+		else if (auto NumericProperty = CastField<FNumericProperty>(Property))
+		{
+			if (auto Enum = NumericProperty->GetIntPropertyEnum())
+			{
+				WriteValue(Writer, Identifier, Enum->GetNameStringByValue(NumericProperty->GetSignedIntPropertyValue(Value)));
+			}
+			else if (NumericProperty->IsFloatingPoint())
+			{
+				WriteValue(Writer, Identifier, NumericProperty->GetFloatingPointPropertyValue(Value));
+			}
+			else
+			{
+				// json numbers are doubles
+				WriteValue(Writer, Identifier, static_cast<double>(NumericProperty->GetSignedIntPropertyValue(Value)));
+			}
+		}
+		else if (auto BoolProperty = CastField<FBoolProperty>(Property))
+		{
+			WriteValue(Writer, Identifier, BoolProperty->GetPropertyValue(Value));
+		}
+		else if (auto StrProperty = CastField<FStrProperty>(Property))
+		{
+			WriteValue(Writer, Identifier, StrProperty->GetPropertyValue(Value));
+		}
+		else if (auto TextProperty = CastField<FTextProperty>(Property))
+		{
+			WriteValue(Writer, Identifier, TextProperty->GetPropertyValue(Value).ToString());
+		}
+		else if (auto ArrayProperty = CastField<FArrayProperty>(Property))
+		{
+			WriteArrayStart(Writer, Identifier);
+
+			FScriptArrayHelper Helper(ArrayProperty, Value);
+			for (int32 i = 0; i < Helper.Num(); i++)
+			{
+				WriteScalar(Writer, nullptr, ArrayProperty->Inner, Helper.GetRawPtr(i));
+			}
+
+			Writer.WriteArrayEnd();
+		}
+		else if (auto SetProperty = CastField<FSetProperty>(Property))
+		{
+			WriteArrayStart(Writer, Identifier);
+
+			FScriptSetHelper Helper(SetProperty, Value);
+			for (int32 i = 0; i < Helper.GetMaxIndex(); i++)
+			{
+				if (Helper.IsValidIndex(i))
+					WriteScalar(Writer, nullptr, SetProperty->ElementProp, Helper.GetElementPtr(i));
+			}
+
+			Writer.WriteArrayEnd();
+		}
+		else if (auto MapProperty = CastField<FMapProperty>(Property))
+		{
+			WriteObjectStart(Writer, Identifier);
+
+			FScriptMapHelper Helper(MapProperty, Value);
+			for (int32 i = 0; i < Helper.GetMaxIndex(); i++)
+			{
+				if (!Helper.IsValidIndex(i))
+					continue;
+
+				FString Key;
+				if (auto KeyStrProperty = CastField<FStrProperty>(MapProperty->KeyProp))
+					Key = KeyStrProperty->GetPropertyValue(Helper.GetKeyPtr(i));
+				else
+					MapProperty->KeyProp->ExportTextItem(Key, Helper.GetKeyPtr(i), nullptr, nullptr, PPF_None);
+
+				WriteScalar(Writer, &Key, MapProperty->ValueProp, Helper.GetValuePtr(i));
+			}
+
+			Writer.WriteObjectEnd();
+		}
+		else if (auto StructProperty = CastField<FStructProperty>(Property))
+		{
+			auto CppStructOps = StructProperty->Struct->GetCppStructOps();
+
+			// structs with own text export (like FDateTime) are written as strings
+			if (CppStructOps && CppStructOps->HasExportTextItem())
+			{
+				FString Text;
+				CppStructOps->ExportTextItem(Text, Value, nullptr, nullptr, PPF_None, nullptr);
+				WriteValue(Writer, Identifier, Text);
+			}
+			else
+			{
+				WriteObjectStart(Writer, Identifier);
+				WriteProperties(Writer, StructProperty->Struct, Value);
+				Writer.WriteObjectEnd();
+			}
+		}
+		else
+		{
+			FString Text;
+			Property->ExportTextItem(Text, Value, nullptr, nullptr, PPF_None);
+			WriteValue(Writer, Identifier, Text);
+		}
+	}
+
+	void WriteProperties(FMBJsonWriter& Writer, const UStruct* Struct, const void* Data)
+	{
+		for (TFieldIterator<FProperty> It(Struct); It; ++It)
+		{
+			FProperty* Property = *It;
+
+			const FString Key = FJsonObjectConverter::StandardizeCase(Property->GetAuthoredName());
+
+			if (Property->ArrayDim == 1)
+			{
+				WriteScalar(Writer, &Key, Property, Property->ContainerPtrToValuePtr<void>(Data));
+				continue;
+			}
+
+			Writer.WriteArrayStart(Key);
+
+			for (int32 i = 0; i < Property->ArrayDim; i++)
+			{
+				WriteScalar(Writer, nullptr, Property, Property->ContainerPtrToValuePtr<void>(Data, i));
+			}
+
+			Writer.WriteArrayEnd();
+		}
+	}
+
+	FProperty* FindProperty(const UStruct* Struct, const FString& Key)
+	{
+		for (TFieldIterator<FProperty> It(Struct); It; ++It)
+		{
+			if (It->GetName().Equals(Key, ESearchCase::IgnoreCase) || It->GetAuthoredName().Equals(Key, ESearchCase::IgnoreCase))
+				return *It;
+		}
+
+		return nullptr;
+	}
+
+	bool ImportEnum(const UEnum* Enum, FNumericProperty* UnderlyingProperty, const FMBJsonReader& Reader, EJsonNotation Notation, void* Value)
+	{
+		if (Notation == EJsonNotation::String)
+		{
+			const int64 EnumValue = Enum->GetValueByNameString(Reader.GetValueAsString());
+			if (EnumValue == INDEX_NONE)
+				return false;
+
+			UnderlyingProperty->SetIntPropertyValue(Value, EnumValue);
+			return true;
+		}
+
+		UnderlyingProperty->SetIntPropertyValue(Value, static_cast<int64>(FMBJsonCodec::GetValueAsNumber(Reader, Notation)));
+		return true;
+	}
+
+	bool SkipMismatchedValue(FMBJsonReader& Reader, EJsonNotation Notation)
+	{
+		FMBJsonCodec::SkipValue(Reader, Notation);
+		return false;
+	}
+
+	// consumes the whole value even if it can't be imported
+	bool ReadScalar(FMBJsonReader& Reader, EJsonNotation Notation, FProperty* Property, void* Value)
+	{
+		const bool IsObject = Notation == EJsonNotation::ObjectStart;
+		const bool IsArray = Notation == EJsonNotation::ArrayStart;
+
+		if (auto ArrayProperty = CastField<FArrayProperty>(Property))
+		{
+			if (!IsArray)
+				return SkipMismatchedValue(Reader, Notation);
+
+			FScriptArrayHelper Helper(ArrayProperty, Value);
+			Helper.EmptyValues();
+
+			bool Result = true;
+
+			EJsonNotation ElementNotation = EJsonNotation::None;
+			while (Reader.ReadNext(ElementNotation) && ElementNotation != EJsonNotation::ArrayEnd)
+			{
+				const int32 Index = Helper.AddValue();
+				Result &= ReadScalar(Reader, ElementNotation, ArrayProperty->Inner, Helper.GetRawPtr(Index));
+			}
+
+			return Result && ElementNotation == EJsonNotation::ArrayEnd;
+		}
+
+		if (auto SetProperty = CastField<FSetProperty>(Property))
+		{
+			if (!IsArray)
+				return SkipMismatchedValue(Reader, Notation);
+
+			FScriptSetHelper Helper(SetProperty, Value);
+			Helper.EmptyElements();
+
+			bool Result = true;
+
+			EJsonNotation ElementNotation = EJsonNotation::None;
+			while (Reader.ReadNext(ElementNotation) && ElementNotation != EJsonNotation::ArrayEnd)
+			{
+				const int32 Index = Helper.AddDefaultValue_Invalid_NeedsRehash();
+				Result &= ReadScalar(Reader, ElementNotation, SetProperty->ElementProp, Helper.GetElementPtr(Index));
+			}
+
+			Helper.Rehash();
+
+			return Result && ElementNotation == EJsonNotation::ArrayEnd;
+		}
+
+		if (auto MapProperty = CastField<FMapProperty>(Property))
+		{
+			if (!IsObject)
+				return SkipMismatchedValue(Reader, Notation);
+
+			FScriptMapHelper Helper(MapProperty, Value);
+			Helper.EmptyValues();
+
+			bool Result = true;
+
+			EJsonNotation ValueNotation = EJsonNotation::None;
+			while (Reader.ReadNext(ValueNotation) && ValueNotation != EJsonNotation::ObjectEnd)
+			{
+				const int32 Index = Helper.AddDefaultValue_Invalid_NeedsRehash();
+
+				if (auto KeyStrProperty = CastField<FStrProperty>(MapProperty->KeyProp))
+					KeyStrProperty->SetPropertyValue(Helper.GetKeyPtr(Index), Reader.GetIdentifier());
+				else
+					Result &= MapProperty->KeyProp->ImportText(*Reader.GetIdentifier(), Helper.GetKeyPtr(Index), PPF_None, nullptr) != nullptr;
+
+				Result &= ReadScalar(Reader, ValueNotation, MapProperty->ValueProp, Helper.GetValuePtr(Index));
+			}
+
+			Helper.Rehash();
+
+			return Result && ValueNotation == EJsonNotation::ObjectEnd;
+		}
+
+		if (auto StructProperty = CastField<FStructProperty>(Property))
+		{
+			if (IsObject)
+				return FMBJsonCodec::ReadStruct(Reader, StructProperty->Struct, Value);
+
+			if (Notation != EJsonNotation::String)
+				return SkipMismatchedValue(Reader, Notation);
+
+			const FString& Text = Reader.GetValueAsString();
+			const TCHAR* Buffer = *Text;
+
+			auto CppStructOps = StructProperty->Struct->GetCppStructOps();
+			if (CppStructOps && CppStructOps->HasImportTextItem() && CppStructOps->ImportTextItem(Buffer, Value, PPF_None, nullptr, GWarn))
+				return true;
+
+			return Property->ImportText(*Text, Value, PPF_None, nullptr) != nullptr;
+		}
+
+		if (IsObject || IsArray)
+			return SkipMismatchedValue(Reader, Notation);
+
+		if (Notation == EJsonNotation::Null)
+			return true;
+
+		if (auto EnumProperty = CastField<FEnumProperty>(Property))
+		{
+			return ImportEnum(EnumProperty->GetEnum(), EnumProperty->GetUnderlyingProperty(), Reader, Notation, Value);
+		}
+
+		if (auto NumericProperty = CastField<FNumericProperty>(Property))
+		{
+			if (auto Enum = NumericProperty->GetIntPropertyEnum())
+				return ImportEnum(Enum, NumericProperty, Reader, Notation, Value);
+
+			if (NumericProperty->IsFloatingPoint())
+			{
+				NumericProperty->SetFloatingPointPropertyValue(Value, FMBJsonCodec::GetValueAsNumber(Reader, Notation));
+			}
+			else if (Notation == EJsonNotation::String)
+			{
+				// parse int64 from string directly to not lose precision in double
+				NumericProperty->SetIntPropertyValue(Value, FCString::Atoi64(*Reader.GetValueAsString()));
+			}
+			else
+			{
+				NumericProperty->SetIntPropertyValue(Value, static_cast<int64>(FMBJsonCodec::GetValueAsNumber(Reader, Notation)));
+			}
+
+			return true;
+		}
+
+		if (auto BoolProperty = CastField<FBoolProperty>(Property))
+		{
+			BoolProperty->SetPropertyValue(Value, FMBJsonCodec::GetValueAsBool(Reader, Notation));
+			return true;
+		}
+
+		if (auto StrProperty = CastField<FStrProperty>(Property))
+		{
+			StrProperty->SetPropertyValue(Value, FMBJsonCodec::GetValueAsString(Reader, Notation));
+			return true;
+		}
+
+		if (auto TextProperty = CastField<FTextProperty>(Property))
+		{
+			TextProperty->SetPropertyValue(Value, FText::FromString(FMBJsonCodec::GetValueAsString(Reader, Notation)));
+			return true;
+		}
+
+		const FString Text = FMBJsonCodec::GetValueAsString(Reader, Notation);
+		return Property->ImportText(*Text, Value, PPF_None, nullptr) != nullptr;
+	}
+}
+
+TSharedRef<FMBJsonWriter> FMBJsonCodec::CreateWriter(FString& OutString)
+{
+	return TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&OutString);
+}
+
+TSharedRef<FMBJsonReader> FMBJsonCodec::CreateReader(const FString& JsonString)
+{
+	return TJsonReaderFactory<TCHAR>::Create(JsonString);
+}
+
+void FMBJsonCodec::WriteStruct(FMBJsonWriter& Writer, const UStruct* Struct, const void* Data)
+{
+	Writer.WriteObjectStart();
+	WriteProperties(Writer, Struct, Data);
+	Writer.WriteObjectEnd();
+}
+
+void FMBJsonCodec::WriteStruct(FMBJsonWriter& Writer, const FString& Identifier, const UStruct* Struct, const void* Data)
+{
+	Writer.WriteObjectStart(Identifier);
+	WriteProperties(Writer, Struct, Data);
+	Writer.WriteObjectEnd();
+}
+
+bool FMBJsonCodec::ReadStruct(FMBJsonReader& Reader, const UStruct* Struct, void* Data)
+{
+	bool Result = true;
+
+	EJsonNotation Notation = EJsonNotation::None;
+	while (Reader.ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
+	{
+		const FString& Key = Reader.GetIdentifier();
+
+		FProperty* Property = FindProperty(Struct, Key);
+
+		// missing and unknown properties are allowed, like in FJsonObjectConverter
+		if (!Property)
+		{
+			Result &= SkipValue(Reader, Notation);
+			continue;
+		}
+
+		if (Property->ArrayDim == 1)
+		{
+			Result &= ReadScalar(Reader, Notation, Property, Property->ContainerPtrToValuePtr<void>(Data));
+			continue;
+		}
+
+		if (Notation != EJsonNotation::ArrayStart)
+		{
+			Result &= SkipMismatchedValue(Reader, Notation);
+			continue;
+		}
+
+		int32 Index = 0;
+
+		EJsonNotation ElementNotation = EJsonNotation::None;
+		while (Reader.ReadNext(ElementNotation) && ElementNotation != EJsonNotation::ArrayEnd)
+		{
+			if (Index < Property->ArrayDim)
+				Result &= ReadScalar(Reader, ElementNotation, Property, Property->ContainerPtrToValuePtr<void>(Data, Index++));
+			else
+				Result &= SkipValue(Reader, ElementNotation);
+		}
+	}
+
+	if (Notation != EJsonNotation::ObjectEnd)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMBJsonCodec::ReadStruct() - Failed to read %s: %s"), *Struct->GetName(), *Reader.GetErrorMessage());
+		return false;
+	}
+
+	return Result;
+}
+
+bool FMBJsonCodec::SkipValue(FMBJsonReader& Reader, EJsonNotation Notation)
+{
+	switch (Notation)
+	{
+	case EJsonNotation::ObjectStart:
+		return Reader.SkipObject();
+	case EJsonNotation::ArrayStart:
+		return Reader.SkipArray();
+	case EJsonNotation::Error:
+		return false;
+	default:
+		return true;
+	}
+}
+
+FString FMBJsonCodec::GetValueAsString(const FMBJsonReader& Reader, EJsonNotation Notation)
+{
+	switch (Notation)
+	{
+	case EJsonNotation::String:
+		return Reader.GetValueAsString();
+	case EJsonNotation::Number:
+		return FString::SanitizeFloat(Reader.GetValueAsNumber(), 0);
+	case EJsonNotation::Boolean:
+		return Reader.GetValueAsBoolean() ? TEXT("true") : TEXT("false");
+	default:
+		return FString();
+	}
+}
+
+double FMBJsonCodec::GetValueAsNumber(const FMBJsonReader& Reader, EJsonNotation Notation)
+{
+	switch (Notation)
+	{
+	case EJsonNotation::Number:
+		return Reader.GetValueAsNumber();
+	case EJsonNotation::String:
+		return FCString::Atod(*Reader.GetValueAsString());
+	case EJsonNotation::Boolean:
+		return Reader.GetValueAsBoolean() ? 1.0 : 0.0;
+	default:
+		return 0.0;
+	}
+}
+
+bool FMBJsonCodec::GetValueAsBool(const FMBJsonReader& Reader, EJsonNotation Notation)
+{
+	switch (Notation)
+	{
+	case EJsonNotation::Boolean:
+		return Reader.GetValueAsBoolean();
+	case EJsonNotation::Number:
+		return Reader.GetValueAsNumber() != 0.0;
+	case EJsonNotation::String:
+		return Reader.GetValueAsString().ToBool();
+	default:
+		return false;
+	}
+}
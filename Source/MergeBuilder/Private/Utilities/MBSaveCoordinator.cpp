@@ -0,0 +1,229 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utilities/MBSaveCoordinator.h"
+#include "Utilities/MBStorageWriter.h"
+#include "Misc/FileHelper.h"
+#include "Async/Async.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "UObject/ObjectVersion.h"
+
+namespace
+{
+	// "MBSV"
+	constexpr uint32 StorageFileMagic = 0x5653424D;
+	constexpr int32 StorageFileFormatVersion = 1;
+
+	constexpr int32 SnapshotVersion = 1;
+
+	FString GetSnapshotPath()
+	{
+		return FPaths::ProjectSavedDir() + "UserData/Snapshot.sav";
+	}
+}
+
+FMBSaveCoordinator& FMBSaveCoordinator::Get()
+{
+	static FMBSaveCoordinator Coordinator;
+	return Coordinator;
+}
+
+void FMBSaveCoordinator::Preload(FOnSnapshotPreloaded OnPreloaded)
+{
+	if (SnapshotLoaded || PreloadedSnapshot.IsValid())
+	{
+		if (OnPreloaded)
+		{
+			LoadSnapshot();
+
+			TSet<FString> SectionNames;
+			Sections.GetKeys(SectionNames);
+			OnPreloaded(SectionNames);
+		}
+
+		return;
+	}
+
+	FMBStorageWriter::Get().Flush();
+
+	PreloadedSnapshot = Async(EAsyncExecution::ThreadPool, [OnPreloaded = MoveTemp(OnPreloaded)]()
+	{
+		FSnapshot Snapshot;
+		ReadSnapshot(Snapshot);
+
+		if (OnPreloaded)
+		{
+			TSet<FString> SectionNames;
+			Snapshot.Sections.GetKeys(SectionNames);
+			OnPreloaded(SectionNames);
+		}
+
+		return Snapshot;
+	});
+}
+
+const FMBStorageSection* FMBSaveCoordinator::ReadSection(const FString& Name)
+{
+	LoadSnapshot();
+
+	return Sections.Find(Name);
+}
+
+void FMBSaveCoordinator::WriteSection(const FString& Name, FMBStorageSection&& Section)
+{
+	LoadSnapshot();
+
+	Sections.Add(Name, MoveTemp(Section));
+	SnapshotDirty = true;
+
+	if (CommitTickHandle.IsValid())
+		return;
+
+	CommitTickHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FMBSaveCoordinator::HandleCommitTick));
+}
+
+void FMBSaveCoordinator::Commit()
+{
+	OnPreCommit.Broadcast();
+
+	if (CommitTickHandle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(CommitTickHandle);
+		CommitTickHandle.Reset();
+	}
+
+	if (!SnapshotDirty)
+		return;
+
+	SnapshotDirty = false;
+	Generation++;
+
+	FMBStorageSection Snapshot;
+	Snapshot.SchemaVersion = SnapshotVersion;
+	Snapshot.UE4Version = GPackageFileUE4Version;
+	Snapshot.LicenseeUE4Version = GPackageFileLicenseeUE4Version;
+
+	FMemoryWriter Writer(Snapshot.Data);
+	Writer << Generation << Sections;
+
+	WriteStorageFile(GetSnapshotPath(), Snapshot);
+}
+
+bool FMBSaveCoordinator::HandleCommitTick(float DeltaTime)
+{
+	CommitTickHandle.Reset();
+
+	Commit();
+
+	// one shot ticker
+	return false;
+}
+
+void FMBSaveCoordinator::LoadSnapshot()
+{
+	if (SnapshotLoaded)
+		return;
+
+	SnapshotLoaded = true;
+
+	FSnapshot Snapshot;
+
+	if (PreloadedSnapshot.IsValid())
+	{
+		Snapshot = PreloadedSnapshot.Get();
+		PreloadedSnapshot.Reset();
+	}
+	else
+	{
+		FMBStorageWriter::Get().Flush();
+		ReadSnapshot(Snapshot);
+	}
+
+	Generation = Snapshot.Generation;
+	Sections = MoveTemp(Snapshot.Sections);
+}
+
+bool FMBSaveCoordinator::ReadSnapshot(FSnapshot& OutSnapshot)
+{
+	FMBStorageSection SnapshotData;
+	if (!ReadStorageFile(GetSnapshotPath(), SnapshotData))
+		return false;
+
+	if (SnapshotData.SchemaVersion != SnapshotVersion)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMBSaveCoordinator::ReadSnapshot() - Unknown snapshot version %d"), SnapshotData.SchemaVersion);
+		return false;
+	}
+
+	FSnapshot Snapshot;
+
+	FMemoryReader Reader(SnapshotData.Data);
+	Reader << Snapshot.Generation << Snapshot.Sections;
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMBSaveCoordinator::ReadSnapshot() - Failed to read snapshot sections"));
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("FMBSaveCoordinator::ReadSnapshot() - Loaded %d sections of generation %llu"), Snapshot.Sections.Num(), Snapshot.Generation);
+
+	OutSnapshot = MoveTemp(Snapshot);
+	return true;
+}
+
+bool FMBSaveCoordinator::ReadStorageFile(const FString& FilePath, FMBStorageSection& OutSection)
+{
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *FilePath, FILEREAD_Silent))
+		return false;
+
+	FMemoryReader FileReader(FileData);
+
+	uint32 Magic = 0;
+	int32 FormatVersion = 0;
+	int32 PayloadSize = 0;
+	uint32 PayloadCrc = 0;
+
+	FileReader << Magic << FormatVersion << OutSection.UE4Version << OutSection.LicenseeUE4Version << OutSection.SchemaVersion << PayloadSize << PayloadCrc;
+
+	if (FileReader.IsError() || Magic != StorageFileMagic || FormatVersion != StorageFileFormatVersion ||
+		PayloadSize < 0 || PayloadSize > FileReader.TotalSize() - FileReader.Tell())
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMBSaveCoordinator::ReadStorageFile() - Invalid header in %s"), *FilePath);
+		return false;
+	}
+
+	const uint8* Payload = FileData.GetData() + FileReader.Tell();
+
+	if (FCrc::MemCrc32(Payload, PayloadSize) != PayloadCrc)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMBSaveCoordinator::ReadStorageFile() - CRC mismatch in %s"), *FilePath);
+		return false;
+	}
+
+	OutSection.Data = TArray<uint8>(Payload, PayloadSize);
+
+	return true;
+}
+
+void FMBSaveCoordinator::WriteStorageFile(const FString& FilePath, const FMBStorageSection& Section)
+{
+	uint32 Magic = StorageFileMagic;
+	int32 FormatVersion = StorageFileFormatVersion;
+	int32 UE4Version = Section.UE4Version;
+	int32 LicenseeUE4Version = Section.LicenseeUE4Version;
+	int32 SchemaVersion = Section.SchemaVersion;
+	int32 PayloadSize = Section.Data.Num();
+	uint32 PayloadCrc = FCrc::MemCrc32(Section.Data.GetData(), PayloadSize);
+
+	TArray<uint8> FileData;
+	FileData.Reserve(PayloadSize + 32);
+
+	FMemoryWriter FileWriter(FileData);
+	FileWriter << Magic << FormatVersion << UE4Version << LicenseeUE4Version << SchemaVersion << PayloadSize << PayloadCrc;
+	FileWriter.Serialize((void*)Section.Data.GetData(), PayloadSize);
+
+	FMBStorageWriter::Get().Write(FilePath, MoveTemp(FileData));
+}
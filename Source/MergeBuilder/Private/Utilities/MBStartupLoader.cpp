@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utilities/MBStartupLoader.h"
+#include "Utilities/MBSaveCoordinator.h"
+#include "MBUtilityFunctionLibrary.h"
+#include "Misc/FileHelper.h"
+
+FMBStartupLoader& FMBStartupLoader::Get()
+{
+	static FMBStartupLoader Loader;
+	return Loader;
+}
+
+void FMBStartupLoader::Start(const TArray<FString>& StorageNames)
+{
+	StartTime = FPlatformTime::Seconds();
+	InteractiveMarked = false;
+
+	TArray<TPair<FString, TPromise<TOptional<FString>>>> JsonPromises;
+
+	for (const auto& StorageName : StorageNames)
+	{
+		TPromise<TOptional<FString>> Promise;
+		JsonReads.Add(StorageName, Promise.GetFuture());
+		JsonPromises.Emplace(StorageName, MoveTemp(Promise));
+	}
+
+	FMBSaveCoordinator::Get().Preload([JsonPromises = MoveTemp(JsonPromises)](const TSet<FString>& SectionNames) mutable
+	{
+		for (auto& JsonPromise : JsonPromises)
+		{
+			TOptional<FString> Data;
+
+			// json is only read for migration, migrated storages are loaded from the snapshot
+			if (!SectionNames.Contains(JsonPromise.Key))
+			{
+				const FString Path = UMBUtilityFunctionLibrary::GetJsonStoragePath(JsonPromise.Key);
+
+				FString FileData;
+				if (FFileHelper::LoadFileToString(FileData, *Path, FFileHelper::EHashOptions::None, FILEREAD_Silent))
+					Data = MoveTemp(FileData);
+			}
+
+			JsonPromise.Value.SetValue(MoveTemp(Data));
+		}
+	});
+}
+
+bool FMBStartupLoader::TakeJsonStorage(const FString& StorageName, TOptional<FString>& OutData)
+{
+	auto Read = JsonReads.Find(StorageName);
+	if (!Read)
+		return false;
+
+	const double WaitStartTime = FPlatformTime::Seconds();
+
+	OutData = Read->Get();
+	JsonReads.Remove(StorageName);
+
+	const double WaitTime = FPlatformTime::Seconds() - WaitStartTime;
+	if (WaitTime > 0.001)
+	{
+		UE_LOG(LogTemp, Log, TEXT("FMBStartupLoader::TakeJsonStorage() - Waited %.1f ms for %s storage"), WaitTime * 1000.0, *StorageName);
+	}
+
+	return true;
+}
+
+void FMBStartupLoader::DiscardJsonStorage(const FString& StorageName)
+{
+	JsonReads.Remove(StorageName);
+}
+
+void FMBStartupLoader::MarkInteractive()
+{
+	if (InteractiveMarked || StartTime == 0.0)
+		return;
+
+	InteractiveMarked = true;
+
+	UE_LOG(LogTemp, Log, TEXT("FMBStartupLoader::MarkInteractive() - Time to interactive %.2f s"), FPlatformTime::Seconds() - StartTime);
+}
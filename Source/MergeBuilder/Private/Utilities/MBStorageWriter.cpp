@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Utilities/MBStorageWriter.h"
+#include "Async/Async.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+
+FMBStorageWriter& FMBStorageWriter::Get()
+{
+	static FMBStorageWriter Writer;
+	return Writer;
+}
+
+void FMBStorageWriter::Write(const FString& FilePath, TArray<uint8>&& Data)
+{
+	FScopeLock Lock(&QueueLock);
+
+	// replaces data that is not written yet
+	PendingWrites.Add(FilePath, MoveTemp(Data));
+
+	if (WorkerActive)
+		return;
+
+	WorkerActive = true;
+
+	Async(EAsyncExecution::ThreadPool, [this]()
+	{
+		while (WriteNext())
+		{
+		}
+	});
+}
+
+void FMBStorageWriter::Flush()
+{
+	while (WriteNext())
+	{
+	}
+}
+
+bool FMBStorageWriter::WriteNext()
+{
+	FScopeLock FileScopeLock(&FileLock);
+
+	FString FilePath;
+	TArray<uint8> Data;
+
+	{
+		FScopeLock Lock(&QueueLock);
+
+		auto It = PendingWrites.CreateIterator();
+		if (!It)
+		{
+			WorkerActive = false;
+			return false;
+		}
+
+		FilePath = It.Key();
+		Data = MoveTemp(It.Value());
+		It.RemoveCurrent();
+	}
+
+	WriteFile(FilePath, Data);
+
+	return true;
+}
+
+void FMBStorageWriter::WriteFile(const FString& FilePath, const TArray<uint8>& Data)
+{
+	const FString TempFilePath = FilePath + ".tmp";
+
+	if (!FFileHelper::SaveArrayToFile(Data, *TempFilePath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMBStorageWriter::WriteFile() - Failed to write %s"), *TempFilePath);
+		return;
+	}
+
+	// rename replaces the file atomically on mobile platforms
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (PlatformFile.MoveFile(*FilePath, *TempFilePath))
+		return;
+
+	// some platforms can't rename over existing file
+	if (!IFileManager::Get().Move(*FilePath, *TempFilePath, true))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMBStorageWriter::WriteFile() - Failed to replace %s"), *FilePath);
+	}
+}
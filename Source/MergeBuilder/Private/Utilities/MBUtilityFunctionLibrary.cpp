@@ -4,6 +4,13 @@
 #include "Utilities/MBUtilityFunctionLibrary.h"
 #include "Kismet/GameplayStatics.h"
 #include "Misc/FileHelper.h"
+#include "Utilities/MBStorageWriter.h"
+#include "Utilities/MBSaveCoordinator.h"
+#include "Utilities/MBStartupLoader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+#include "UObject/ObjectVersion.h"
 
 #if PLATFORM_ANDROID
 #include "Android/AndroidPlatformMisc.h"
@@ -15,26 +22,115 @@
 
 bool UMBUtilityFunctionLibrary::ReadFromStorage(const FString& StorageName, FString& OutData)
 {
-	FString Path = FPaths::ProjectSavedDir()+ "UserData/" + StorageName + ".json";
-	return FFileHelper::LoadFileToString(OutData, *Path);
+	TOptional<FString> PrefetchedData;
+	if (FMBStartupLoader::Get().TakeJsonStorage(StorageName, PrefetchedData))
+	{
+		if (!PrefetchedData.IsSet())
+			return false;
+
+		OutData = MoveTemp(PrefetchedData.GetValue());
+		return true;
+	}
+
+	FMBStorageWriter::Get().Flush();
+
+	return FFileHelper::LoadFileToString(OutData, *GetJsonStoragePath(StorageName));
 }
 
 void UMBUtilityFunctionLibrary::SaveToStorage(const FString& StorageName, const FString& Data)
 {
-	FString Path = FPaths::ProjectSavedDir() + "UserData/" + StorageName + ".json";
-	FFileHelper::SaveStringToFile(Data, *Path);
+	FMBStartupLoader::Get().DiscardJsonStorage(StorageName);
+
+	TArray<uint8> FileData;
+	EncodeStorageString(Data, FileData);
+
+	FMBStorageWriter::Get().Write(GetJsonStoragePath(StorageName), MoveTemp(FileData));
 }
 
-bool UMBUtilityFunctionLibrary::StringToJsonObject(const FString& JsonString, TSharedPtr<FJsonObject>& OutObject)
+void UMBUtilityFunctionLibrary::EncodeStorageString(const FString& Data, TArray<uint8>& OutFileData)
 {
-	const TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<TCHAR>::Create(JsonString);
-	return FJsonSerializer::Deserialize(Reader, OutObject);
+	OutFileData.Reset();
+
+	if (FCString::IsPureAnsi(*Data))
+	{
+		FTCHARToANSI AnsiData(*Data);
+		OutFileData.Append((const uint8*)AnsiData.Get(), AnsiData.Length());
+		return;
+	}
+
+	const UTF16CHAR BOM = UNICODE_BOM;
+	OutFileData.Append((const uint8*)&BOM, sizeof(BOM));
+
+	FTCHARToUTF16 Utf16Data(*Data);
+	OutFileData.Append((const uint8*)Utf16Data.Get(), Utf16Data.Length() * sizeof(UTF16CHAR));
 }
 
-void UMBUtilityFunctionLibrary::JsonObjectToString(TSharedPtr<FJsonObject> JsonObject, FString& OutString)
+FString UMBUtilityFunctionLibrary::GetJsonStoragePath(const FString& StorageName)
 {
-	const auto Json_writer = TJsonWriterFactory<>::Create(&OutString);
-	FJsonSerializer::Serialize(JsonObject.ToSharedRef(), Json_writer);
+	return FPaths::ProjectSavedDir() + "UserData/" + StorageName + ".json";
+}
+
+namespace
+{
+#if !UE_BUILD_SHIPPING
+	TAutoConsoleVariable<int32> CVarExportJsonStorage(TEXT("mb.ExportJsonStorage"),
+		0,
+		TEXT("Write json copy next to every binary storage file.\n")
+		TEXT("	0: off\n")
+		TEXT("  1: on"));
+#endif
+}
+
+bool UMBUtilityFunctionLibrary::ReadBinaryFromStorage(const FString& StorageName, FStorageSerializer Serializer)
+{
+	const FMBStorageSection* Section = FMBSaveCoordinator::Get().ReadSection(StorageName);
+
+	if (!Section)
+		return false;
+
+	FMemoryReader PayloadReader(Section->Data, true);
+	PayloadReader.SetUE4Ver(Section->UE4Version);
+	PayloadReader.SetLicenseeUE4Ver(Section->LicenseeUE4Version);
+
+	FObjectAndNameAsStringProxyArchive Ar(PayloadReader, true);
+	Serializer(Ar, Section->SchemaVersion);
+
+	if (Ar.IsError())
+	{
+		UE_LOG(LogTemp, Error, TEXT("UMBUtilityFunctionLibrary::ReadBinaryFromStorage() - Failed to read %s storage with version %d"), *StorageName, Section->SchemaVersion);
+		return false;
+	}
+
+	return true;
+}
+
+void UMBUtilityFunctionLibrary::SaveBinaryToStorage(const FString& StorageName, int32 SchemaVersion, FStorageSerializer Serializer)
+{
+	FMBStorageSection Section;
+	Section.SchemaVersion = SchemaVersion;
+	Section.UE4Version = GPackageFileUE4Version;
+	Section.LicenseeUE4Version = GPackageFileLicenseeUE4Version;
+
+	FMemoryWriter PayloadWriter(Section.Data, true);
+	FObjectAndNameAsStringProxyArchive Ar(PayloadWriter, false);
+	Serializer(Ar, SchemaVersion);
+
+	FMBSaveCoordinator::Get().WriteSection(StorageName, MoveTemp(Section));
+}
+
+bool UMBUtilityFunctionLibrary::IsJsonExportEnabled()
+{
+#if !UE_BUILD_SHIPPING
+	return CVarExportJsonStorage.GetValueOnGameThread() != 0;
+#else
+	return false;
+#endif
+}
+
+bool UMBUtilityFunctionLibrary::StringToJsonObject(const FString& JsonString, TSharedPtr<FJsonObject>& OutObject)
+{
+	const TSharedRef<TJsonReader<TCHAR>> Reader = TJsonReaderFactory<TCHAR>::Create(JsonString);
+	return FJsonSerializer::Deserialize(Reader, OutObject);
 }
 
 const FString UMBUtilityFunctionLibrary::EnumToString(const FString& Enum, int32 EnumValue)
@@ -68,13 +164,12 @@ void UMBUtilityFunctionLibrary::GetMergeItemData(const FMergeFieldItem& Item, FM
 	auto GI = UGameplayStatics::GetGameInstance(GEngine->GameViewport->GetWorld());
 	auto MergeSubsystem = GI->GetSubsystem<UMergeSubsystem>();
 
-	FString RowName = EnumToString("EMergeItemType", (int32)Item.Type);
-	auto Row = MergeSubsystem->MergeItemsDataTable->FindRow<FMergeItemChainRow>(FName(RowName),"");
+	auto ItemData = MergeSubsystem->GetItemData(Item);
 
-	if (!Row)
+	if (!ItemData)
 		return;
 	
-	OutData = Row->ItemsChain[Item.Level - 1];
+	OutData = *ItemData;
 }
 
 bool UMBUtilityFunctionLibrary::IsMergeItemMaxLevel(const FMergeFieldItem& Item)
@@ -82,13 +177,7 @@ bool UMBUtilityFunctionLibrary::IsMergeItemMaxLevel(const FMergeFieldItem& Item)
 	auto GI = UGameplayStatics::GetGameInstance(GEngine->GameViewport->GetWorld());
 	auto MergeSubsystem = GI->GetSubsystem<UMergeSubsystem>();
 
-	FString RowName = EnumToString("EMergeItemType", (int32)Item.Type);
-	auto Row = MergeSubsystem->MergeItemsDataTable->FindRow<FMergeItemChainRow>(FName(RowName),"");
-
-	if (!Row)
-		return false;
-
-	return Row->ItemsChain.Num() == Item.Level;
+	return MergeSubsystem->GetItemMaxLevel(Item.Type) == Item.Level;
 }
 
 int32 UMBUtilityFunctionLibrary::GetSkipTimerPrice(const FTimespan& TotalTime, const FTimespan& RemainTime,
@@ -3,7 +3,7 @@
 
 #include "Utilities/ShopSubsystem.h"
 
-#include "JsonObjectConverter.h"
+#include "Utilities/MBJsonCodec.h"
 #include "MBUtilityFunctionLibrary.h"
 #include "TimeSubsystem.h"
 #include "Analytics/FGAnalytics.h"
@@ -26,6 +26,34 @@ void UShopSubsystem::Init()
 	RequestStoreProductsInfo();
 
 	ParseHistory();
+
+	auto TimeSubsystem = UGameplayStatics::GetGameInstance(GetWorld())->GetSubsystem<UTimeSubsystem>();
+
+	// reset deadline is moved to the server midnight after each time sync
+	TimeSubsystem->OnTimeSuccessRequested.AddUObject(this, &UShopSubsystem::SchedulePurchaseLimitsReset);
+
+	if (TimeSubsystem->IsTimeValid())
+	{
+		SchedulePurchaseLimitsReset();
+	}
+}
+
+void UShopSubsystem::SchedulePurchaseLimitsReset()
+{
+	auto TimeSubsystem = UGameplayStatics::GetGameInstance(GetWorld())->GetSubsystem<UTimeSubsystem>();
+	TimeSubsystem->RemoveDeadline(LimitsResetDeadlineID);
+
+	// limits are counted per UTC day
+	const FDateTime NextDay = TimeSubsystem->GetUTCNow().GetDate() + FTimespan::FromDays(1);
+
+	FSimpleDelegate Callback = FSimpleDelegate::CreateWeakLambda(this, [this]()
+	{
+		LimitsResetDeadlineID = 0;
+		OnPurchaseLimitsReset.Broadcast();
+		SchedulePurchaseLimitsReset();
+	});
+
+	LimitsResetDeadlineID = TimeSubsystem->AddDeadline(NextDay, Callback);
 }
 
 void UShopSubsystem::GetStorePriceText(const FString& ProductID, FText& PriceText)
@@ -62,48 +90,67 @@ bool UShopSubsystem::GetGooglePlayOfferInfo(const FString& ProductID, FSkuDetail
 
 void UShopSubsystem::ParseHistory()
 {
+	const bool BinaryLoaded = UMBUtilityFunctionLibrary::ReadBinaryFromStorage("ShopHistory", [this](FArchive& Ar, int32 Version)
+	{
+		SerializeStructArray(Ar, ProductsHistory);
+	});
+
+	if (BinaryLoaded)
+		return;
+
+	ProductsHistory.Empty();
+
+	// migrate history from json storage
 	FString SavedData;
 	if (!UMBUtilityFunctionLibrary::ReadFromStorage("ShopHistory", SavedData))
 		return;
 
-	TSharedPtr<FJsonObject> JsonObject;
+	auto Reader = FMBJsonCodec::CreateReader(SavedData);
 
-	if (!UMBUtilityFunctionLibrary::StringToJsonObject(SavedData, JsonObject))
+	EJsonNotation Notation;
+	if (!Reader->ReadNext(Notation) || Notation != EJsonNotation::ObjectStart)
 		return;
-	
-	const TArray<TSharedPtr<FJsonValue>>* ValuesArray;
-	if (JsonObject->TryGetArrayField("Products", ValuesArray))
+
+	while (Reader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
 	{
-		for (const auto& ProductValue : *ValuesArray)
-		{
-			FPurchaseHistory PurchaseHistory;
-			if (!FJsonObjectConverter::JsonObjectToUStruct<FPurchaseHistory>(ProductValue->AsObject().ToSharedRef(), &PurchaseHistory))
-				continue;
-			
-			ProductsHistory.Add(PurchaseHistory);
-		}
+		if (Reader->GetIdentifier() == "Products" && Notation == EJsonNotation::ArrayStart)
+			FMBJsonCodec::ReadStructArray(*Reader, ProductsHistory);
+		else
+			FMBJsonCodec::SkipValue(*Reader, Notation);
 	}
+
+	SaveHistory();
 }
 
 void UShopSubsystem::SaveHistory()
 {
-	TSharedPtr<FJsonObject> JsonObject = MakeShared<FJsonObject>();
+	UMBUtilityFunctionLibrary::SaveBinaryToStorage("ShopHistory", ShopHistoryStorageVersion, [this](FArchive& Ar, int32 Version)
+	{
+		SerializeStructArray(Ar, ProductsHistory);
+	});
+
+	if (UMBUtilityFunctionLibrary::IsJsonExportEnabled())
+	{
+		ExportHistoryJson();
+	}
+}
+
+void UShopSubsystem::ExportHistoryJson()
+{
+	FString StringData;
+	auto Writer = FMBJsonCodec::CreateWriter(StringData);
 
-	TArray<TSharedPtr<FJsonValue>> ValuesArray;
+	Writer->WriteObjectStart();
+	Writer->WriteArrayStart("Products");
 
 	for (const auto& Product : ProductsHistory)
 	{
-		TSharedPtr<FJsonObject> ProductObject = FJsonObjectConverter::UStructToJsonObject<FPurchaseHistory>(Product);
-		TSharedPtr<FJsonValueObject> ProductValue = MakeShared<FJsonValueObject>(ProductObject);
-
-		ValuesArray.Add(ProductValue);
+		FMBJsonCodec::WriteStruct(*Writer, Product);
 	}
 
-	JsonObject->SetArrayField("Products", ValuesArray);
-	
-
-	FString StringData;
-	UMBUtilityFunctionLibrary::JsonObjectToString(JsonObject, StringData);
+	Writer->WriteArrayEnd();
+	Writer->WriteObjectEnd();
+	Writer->Close();
 
 	UMBUtilityFunctionLibrary::SaveToStorage("ShopHistory", StringData);
 }
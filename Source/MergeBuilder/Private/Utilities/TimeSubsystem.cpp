@@ -5,97 +5,229 @@
 #include "WebRequestSubsystem.h"
 #include "MBUtilityFunctionLibrary.h"
 #include "MBGameInstance.h"
+#include "Dom/JsonObject.h"
 
 UTimeSubsystem::UTimeSubsystem()
 {
-    TimeAPI_URLs.Add("timeapi.io/api/Time/current/zone?timeZone=Etc/UTC", "dateTime");
-    TimeAPI_URLs.Add("worldtimeapi.org/api/timezone/Etc/UTC", "datetime");
+    // used when Game config has no endpoints
+    TimeEndpoints.Add(FTimeEndpoint("timeapi.io/api/Time/current/zone?timeZone=Etc/UTC", "dateTime"));
+    TimeEndpoints.Add(FTimeEndpoint("worldtimeapi.org/api/timezone/Etc/UTC", "datetime"));
 }
 
 void UTimeSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
+    const bool OffsetLoaded = UMBUtilityFunctionLibrary::ReadBinaryFromStorage("Time", [this](FArchive& Ar, int32 Version)
+    {
+        Ar << TrustedOffset;
+    });
+
+    if (OffsetLoaded)
+    {
+        // game starts right away, server time is verified in background
+        SetAnchor(FDateTime::UtcNow() + TrustedOffset);
+        TimeValid = true;
+    }
+
     FTimerDelegate Delegate = FTimerDelegate::CreateUObject(this, &UTimeSubsystem::RequestTime);
     GetWorld()->GetTimerManager().SetTimerForNextTick(Delegate);
 
     auto GI = Cast<UMBGameInstance>(GetGameInstance());
-    GI->ApplicationHasEnteredForegroundDelegate.AddDynamic(this, &UTimeSubsystem::RequestTime);
+    GI->ApplicationWillEnterBackgroundDelegate.AddDynamic(this, &UTimeSubsystem::HandleEnterBackground);
+    GI->ApplicationHasEnteredForegroundDelegate.AddDynamic(this, &UTimeSubsystem::HandleEnterForeground);
 }
 
 void UTimeSubsystem::Deinitialize()
 {
+    GetGameInstance()->GetTimerManager().ClearTimer(DeadlineTimerHandle);
 }
 
 void UTimeSubsystem::RequestTime()
 {
-
-    if (RemainURLs.Num() == 0)
+    if (TimeEndpoints.Num() == 0)
     {
-        RemainURLs = TimeAPI_URLs;
+        UE_LOG(LogTemp, Error, TEXT("UTimeSubsystem::RequestTime() - No time endpoints configured"));
+        return;
     }
-    
-    auto WebRequestSystem = GetGameInstance()->GetSubsystem<UWebRequestSubsystem>();
 
-    FString URL;
-    FString ParamName;
-    TArray<FString> Keys;
-    RemainURLs.GetKeys(Keys);
-    URL = Keys[0];
-    RemainURLs.RemoveAndCopyValue(Keys[0], ParamName);
+    // new round replaces requests which are still in flight
+    RequestRound++;
+    PendingRequests = TimeEndpoints.Num();
+
+    auto WebRequestSystem = GetGameInstance()->GetSubsystem<UWebRequestSubsystem>();
 
     TArray<TPair<FString, FString>> Headers;
-    FHttpRequestCompleteDelegate& CompleteDelegate = WebRequestSystem->CallWebScript(URL, Headers, true);
-
-    CompleteDelegate.BindLambda([this, ParamName](FHttpRequestPtr RequestPtr, FHttpResponsePtr ResponsePtr, bool bSuccessful) {
-        
-        if (bSuccessful)
-        {
-            RemainURLs.Empty();
-            TSharedPtr<FJsonObject> JsonResponse;
-            UMBUtilityFunctionLibrary::StringToJsonObject(ResponsePtr->GetContentAsString(), JsonResponse);
-
-            FString StringDate = JsonResponse->GetStringField(ParamName);
-            FDateTime::ParseIso8601(*StringDate, TimeUTC);
-
-            TimeValid = true;
-
-            OnTimeSuccessRequested.Broadcast();
-
-            if (!GetWorld())
-                return;
-
-            if (GetWorld()->GetTimerManager().IsTimerActive(RecalculationTimer))
-            {
-                GetWorld()->GetTimerManager().ClearTimer(RecalculationTimer);
-            }
-
-            FTimerDelegate Delegate = FTimerDelegate::CreateUObject(this, &UTimeSubsystem::RecalculateTime);
-            GetWorld()->GetTimerManager().SetTimer(RecalculationTimer, Delegate, 1.0f, true);
-        }
-        else
-        {
-            TimeValid = false;
-            UE_LOG(LogTemp, Warning, TEXT("UTimeSubsystem::RequestTime() - Failed request: %s"), *ResponsePtr->GetContentAsString());
-            FTimerHandle TimerHandle;
-            FTimerDelegate Delegate = FTimerDelegate::CreateUObject(this, &UTimeSubsystem::RequestTime);
-            
-            if (!GetWorld())
-                return;
-            
-            GetWorld()->GetTimerManager().SetTimer(TimerHandle, Delegate, 1.0f, false);
-        }
-
-     });
 
+    for (const auto& Endpoint : TimeEndpoints)
+    {
+        FHttpRequestCompleteDelegate& CompleteDelegate = WebRequestSystem->CallWebScript(Endpoint.URL, Headers, Endpoint.WithSSL);
+        CompleteDelegate.BindUObject(this, &UTimeSubsystem::HandleTimeResponse, RequestRound, Endpoint);
+    }
 }
 
-void UTimeSubsystem::RecalculateTime()
+void UTimeSubsystem::HandleTimeResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bSuccessful, int32 Round, FTimeEndpoint Endpoint)
 {
-    FTimespan RecalculatePeriodTimespan = FTimespan(0, 0, 1);
-    TimeUTC += RecalculatePeriodTimespan;
-    //GEngine->AddOnScreenDebugMessage(0, 1.0f, FColor::Blue, FString::Printf(TEXT("%i h:%i m:%i s"), TimeUTC.GetHour(), TimeUTC.GetMinute(), TimeUTC.GetSecond()));
+    if (Round != RequestRound || PendingRequests == 0)
+        return;
+
+    FDateTime ServerTime;
+    if (bSuccessful && ParseServerTime(Response, Endpoint, ServerTime))
+    {
+        // first valid response wins
+        PendingRequests = 0;
+
+        // server time is taken in the middle of the round trip
+        ServerTime += FTimespan::FromSeconds(Request->GetElapsedTime() * 0.5f);
+
+        SetServerTime(ServerTime);
+        return;
+    }
+
+    UE_LOG(LogTemp, Warning, TEXT("UTimeSubsystem::HandleTimeResponse() - Failed request to %s: %s"), *Endpoint.URL, Response.IsValid() ? *Response->GetContentAsString() : TEXT(""));
+
+    if (--PendingRequests > 0)
+        return;
+
+    if (!GetWorld())
+        return;
+
+    FTimerHandle TimerHandle;
+    FTimerDelegate Delegate = FTimerDelegate::CreateUObject(this, &UTimeSubsystem::RequestTime);
+    GetWorld()->GetTimerManager().SetTimer(TimerHandle, Delegate, RetryDelay, false);
+}
+
+bool UTimeSubsystem::ParseServerTime(FHttpResponsePtr Response, const FTimeEndpoint& Endpoint, FDateTime& OutTime) const
+{
+    if (!Response.IsValid() || !EHttpResponseCodes::IsOk(Response->GetResponseCode()))
+        return false;
+
+    TSharedPtr<FJsonObject> JsonResponse;
+    if (!UMBUtilityFunctionLibrary::StringToJsonObject(Response->GetContentAsString(), JsonResponse))
+        return false;
+
+    FString StringDate;
+    if (!JsonResponse->TryGetStringField(Endpoint.DateTimeField, StringDate))
+        return false;
+
+    return FDateTime::ParseIso8601(*StringDate, OutTime);
+}
+
+void UTimeSubsystem::SetServerTime(const FDateTime& ServerTime)
+{
+    // objects signalled by fired deadlines must stay ready
+    SetAnchor(FMath::Max(ServerTime, FiredUTC));
+    TimeValid = true;
+    TimeVerified = true;
+
+    TrustedOffset = ServerTime - FDateTime::UtcNow();
+
+    UMBUtilityFunctionLibrary::SaveBinaryToStorage("Time", TimeStorageVersion, [this](FArchive& Ar, int32 Version)
+    {
+        Ar << TrustedOffset;
+    });
+
+    OnTimeSuccessRequested.Broadcast();
+
+    // server time can be ahead of the trusted one
+    FireElapsedDeadlines();
+}
+
+void UTimeSubsystem::SetAnchor(const FDateTime& AnchorTime)
+{
+    AnchorUTC = AnchorTime;
+    AnchorSeconds = FPlatformTime::Seconds();
+
+    TimeUTC = AnchorUTC;
+}
+
+void UTimeSubsystem::HandleEnterBackground()
+{
+    // device clock can be changed while the app is suspended, deadlines wait for the server
+    TimeVerified = false;
+
+    GetGameInstance()->GetTimerManager().ClearTimer(DeadlineTimerHandle);
+}
+
+void UTimeSubsystem::HandleEnterForeground()
+{
+    // platform clock may not count device sleep, time catches up on the server response
+    RequestTime();
 }
 
 const FDateTime& UTimeSubsystem::GetUTCNow()
 {
+    if (TimeValid)
+    {
+        TimeUTC = AnchorUTC + FTimespan::FromSeconds(FPlatformTime::Seconds() - AnchorSeconds);
+    }
+
     return TimeUTC;
 }
+
+int32 UTimeSubsystem::AddDeadline(const FDateTime& Time, FSimpleDelegate Callback)
+{
+    const int32 DeadlineID = ++LastDeadlineID;
+
+    DeadlineCallbacks.Add(DeadlineID, MoveTemp(Callback));
+    Deadlines.HeapPush({ Time, DeadlineID });
+
+    // new deadline can be earlier than the scheduled one
+    if (Deadlines.HeapTop().ID == DeadlineID)
+        ScheduleNextDeadline();
+
+    return DeadlineID;
+}
+
+void UTimeSubsystem::RemoveDeadline(int32 DeadlineID)
+{
+    DeadlineCallbacks.Remove(DeadlineID);
+}
+
+void UTimeSubsystem::FireElapsedDeadlines()
+{
+    if (!TimeVerified)
+        return;
+
+    const FDateTime Now = GetUTCNow();
+    FiredUTC = Now;
+
+    // callbacks are collected first, they can add new deadlines
+    TArray<FSimpleDelegate> ElapsedCallbacks;
+
+    while (Deadlines.Num() > 0 && Deadlines.HeapTop().Time <= Now)
+    {
+        FDeadline Deadline;
+        Deadlines.HeapPop(Deadline, false);
+
+        FSimpleDelegate Callback;
+        if (DeadlineCallbacks.RemoveAndCopyValue(Deadline.ID, Callback))
+            ElapsedCallbacks.Add(MoveTemp(Callback));
+    }
+
+    for (auto& Callback : ElapsedCallbacks)
+    {
+        Callback.ExecuteIfBound();
+    }
+
+    ScheduleNextDeadline();
+}
+
+void UTimeSubsystem::ScheduleNextDeadline()
+{
+    auto& TimerManager = GetGameInstance()->GetTimerManager();
+
+    // drop removed deadlines so they don't wake the timer
+    while (Deadlines.Num() > 0 && !DeadlineCallbacks.Contains(Deadlines.HeapTop().ID))
+    {
+        Deadlines.HeapPopDiscard(false);
+    }
+
+    if (!TimeVerified || Deadlines.Num() == 0)
+    {
+        TimerManager.ClearTimer(DeadlineTimerHandle);
+        return;
+    }
+
+    // timer is only a wake up, deadlines are checked by server time when it fires
+    const float Delay = FMath::Max((Deadlines.HeapTop().Time - GetUTCNow()).GetTotalSeconds(), 0.0);
+    TimerManager.SetTimer(DeadlineTimerHandle, this, &UTimeSubsystem::FireElapsedDeadlines, FMath::Max(Delay, 0.01f), false);
+}
@@ -5,11 +5,16 @@
 #include "CoreMinimal.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "CityObjectsData.h"
+#include "CitySystem/CityObjectsIndex.h"
 #include "QuestSystem/MBQuest.h"
 #include "CityBuilderSubsystem.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnUpdateObjects, TArray<int32>, ObjectIDs);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnBuildNewObject, FName, ObjectName);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnGeneratorRestored, int32, ObjectID);
+
+constexpr int32 CityStorageVersion = 1;
+
 /**
  * 
  */
@@ -34,7 +39,8 @@ public:
 	void EditObject(const FCityObject& EditedObject);
 	void RemoveObject(const FCityObject& ObjectToRemove);
 
-	void CollectFromObject(FCityObject& Object);
+	// returns false if the generator is not restored by server time yet
+	bool CollectFromObject(FCityObject& Object);
 
 	UFUNCTION(BlueprintCallable)
 	bool CheckRequierementsForBuildObject(const FName& ObjectName);
@@ -44,6 +50,9 @@ public:
 	void SaveCity();
 
 	void CalculateCurrentPopulationAndRatings();
+
+	UFUNCTION(BlueprintPure)
+	int32 GetUnemployedPopulation() const { return FMath::Max(0, Population - EmployedPopulation); }
 	
 	UFUNCTION(BlueprintCallable)
 	void GetTopRatingsForLevel(int32 Level, FCityRatings& TopRatings);
@@ -56,6 +65,8 @@ public:
 
 	bool HasGenerator(const FName& ObjectName);
 
+	const FCityObjectsIndex& GetObjectsIndex() const { return ObjectsIndex; }
+
 	void SetNewQuestsForObjects(TArray<FString> NewQuests);
 
 	UFUNCTION(BlueprintPure)
@@ -68,10 +79,24 @@ public:
 	
 protected:
 
+	void ScheduleGeneratorRestore(int32 ObjectID);
+
 	void AddExperienceForNewObject(const FName& NewObjectName);
 
+	// adds or subtracts object's population, employees and ratings
+	void ApplyObjectToPopulationAndRatings(const FName& ObjectName, bool bAdd);
+
+	void SumPopulationAndRatings(int32& OutPopulation, int32& OutEmployed, FCityRatings& OutRatings) const;
+
+	// debug check that incremental values match the full recompute
+	void VerifyPopulationAndRatings() const;
+
 	void ParseCity(const FString& JsonString);
 
+	void SerializeCity(FArchive& Ar, int32 Version);
+
+	void ExportCityJson();
+
 	void InitCity();
 
 	void CreateConsoleVariables();
@@ -79,6 +104,11 @@ protected:
 	UPROPERTY()
 	TArray<FCityObject> CityObjects;
 
+	FCityObjectsIndex ObjectsIndex;
+
+	// ObjectID -> restore deadline in time subsystem
+	TMap<int32, int32> RestoreDeadlines;
+
 	UPROPERTY(BlueprintReadOnly)
 	int32 Population = 0;
 
@@ -107,4 +137,7 @@ public:
 
 	UPROPERTY(BlueprintAssignable)
 	FOnBuildNewObject OnBuildNewObject;
+
+	UPROPERTY(BlueprintAssignable)
+	FOnGeneratorRestored OnGeneratorRestored;
 };
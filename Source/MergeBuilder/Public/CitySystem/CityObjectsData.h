@@ -80,6 +80,19 @@ struct FCityRatings
 		Comfort += Other.Comfort;
 		return *this;
 	}
+
+	const FCityRatings& operator-=(const FCityRatings& Other)
+	{
+		Greening -= Other.Greening;
+		Infrastructure -= Other.Infrastructure;
+		Comfort -= Other.Comfort;
+		return *this;
+	}
+
+	bool operator==(const FCityRatings& Other) const
+	{
+		return Greening == Other.Greening && Infrastructure == Other.Infrastructure && Comfort == Other.Comfort;
+	}
 };
 
 
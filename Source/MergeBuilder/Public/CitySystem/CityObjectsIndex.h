@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CityObjectsData.h"
+
+/**
+ * Lookups over city objects table, built once when the table is loaded.
+ * Row pointers point into the table and stay valid while it's loaded.
+ */
+struct MERGEBUILDER_API FCityObjectsIndex
+{
+	void Build(const UDataTable* DataTable);
+
+	const FCityObjectData* FindRow(const FName& ObjectName) const;
+
+	// object that has ObjectName as the next level, NAME_None for the first level
+	FName GetPreviousLevel(const FName& ObjectName) const;
+
+	// first level of the object's chain
+	FName GetChainRoot(const FName& ObjectName) const;
+
+	// generator and its upgraded versions named with level suffix ("Mine", "Mine2", "Mine3")
+	const TArray<FName>& GetGeneratorFamily(const FName& GeneratorName) const;
+
+	// objects that can be required by quests
+	const TArray<FName>& GetQuestObjects() const { return QuestObjects; }
+
+private:
+
+	TMap<FName, const FCityObjectData*> Rows;
+
+	TMap<FName, FName> PreviousLevels;
+
+	TMap<FName, FName> ChainRoots;
+
+	TMap<FName, TArray<FName>> GeneratorFamilies;
+
+	TArray<FName> QuestObjects;
+};
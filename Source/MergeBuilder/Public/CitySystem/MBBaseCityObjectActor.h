@@ -5,9 +5,12 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "CityBuilderSubsystem.h"
+#include "CitySystem/MBCitySpatialGrid.h"
 #include "Components/StaticMeshComponent.h"
 #include "MBBaseCityObjectActor.generated.h"
 
+class AMBCityBuilderManager;
+
 UENUM(BlueprintType)
 enum class ECityObjectLocationState : uint8
 {
@@ -51,6 +54,12 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void TrySnapToClosestObject();
 
+	// footprint of colliding components for the current transform
+	void GetFootprint(FMBCityFootprint& OutFootprint) const;
+
+	// world locations of components with "Snap" tag for the current transform
+	void GetSnapSockets(TArray<FVector>& OutSockets) const;
+
 	UFUNCTION(BlueprintImplementableEvent)
 	void UpdateQuest();
 
@@ -67,4 +76,8 @@ protected:
 
 	UPROPERTY(BlueprintReadOnly, EditAnywhere)
 	bool CanSnap = false;
+
+	// set by the manager that spawned this object, placement queries go through its city grid
+	UPROPERTY()
+	AMBCityBuilderManager* CityManager = nullptr;
 };
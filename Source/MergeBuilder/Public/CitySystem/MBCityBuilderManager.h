@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "CitySystem/MBCitySpatialGrid.h"
 #include "MBCityBuilderManager.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnObjectClicked, AMBBaseCityObjectActor*, ClickedObject);
@@ -60,6 +61,16 @@ public:
 
 	void HandleObjectClick(AMBBaseCityObjectActor* CityObject);
 
+	AMBBaseCityObjectActor* GetCityObjectActor(int32 ObjectID) const;
+
+	// placed objects with intersecting footprints, hidden objects of the current merge are ignored
+	void GetOverlappingCityObjects(const AMBBaseCityObjectActor* Object, const FMBCityFootprint& Footprint, TArray<AMBBaseCityObjectActor*>& OutObjects) const;
+
+	bool IsOnGround(const FMBCityFootprint& Footprint);
+
+	// snap sockets in actor space, they are collected once for every object class
+	const TArray<FVector>& GetClassSnapSockets(const AMBBaseCityObjectActor* Object);
+
 protected:
 
 	UPROPERTY(BlueprintReadOnly)
@@ -74,4 +85,22 @@ protected:
 public:
 
 	int32 BuildGrid = 1.0f;
+
+	// size of city grid cells, about the size of common objects
+	UPROPERTY(EditAnywhere)
+	float CityGridCellSize = 1500.0f;
+
+	// footprints of placed objects, edited object is updated when it's accepted
+	FMBCitySpatialGrid CityGrid;
+
+protected:
+
+	void AddToCityGrid(AMBBaseCityObjectActor* Object);
+
+	// classes are loaded by city objects table while their objects exist
+	TMap<const UClass*, TArray<FVector>> ClassSnapSockets;
+
+	// actors of placed objects by ObjectID
+	UPROPERTY()
+	TMap<int32, AMBBaseCityObjectActor*> CityObjectActors;
 };
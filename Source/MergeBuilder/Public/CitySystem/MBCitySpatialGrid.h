@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AMBBaseCityObjectActor;
+
+/**
+ * Box of a city object on the ground plane, rotated by the object yaw.
+ */
+struct MERGEBUILDER_API FMBCityFootprint
+{
+	FVector2D Center = FVector2D::ZeroVector;
+
+	// half size in object space
+	FVector2D Extent = FVector2D::ZeroVector;
+
+	float Yaw = 0.0f;
+
+	FBox2D GetBounds() const;
+
+	// touching footprints of snapped objects don't intersect
+	bool Intersects(const FMBCityFootprint& Other) const;
+
+private:
+
+	void GetAxes(FVector2D& OutAxisX, FVector2D& OutAxisY) const;
+
+	float GetProjectedRadius(const FVector2D& Axis) const;
+};
+
+/**
+ * Uniform grid over placed city objects.
+ * Object is stored in every cell its footprint bounds cover, so queries only visit the nearby cells.
+ */
+struct MERGEBUILDER_API FMBCitySpatialGrid
+{
+	void Init(float InCellSize);
+
+	// replaces the footprint and sockets if object is already added
+	void Add(AMBBaseCityObjectActor* Object, const FMBCityFootprint& Footprint, TArray<FVector>&& SnapSockets);
+
+	void Remove(AMBBaseCityObjectActor* Object);
+
+	// objects with footprint bounds in the area, every object is returned once
+	void Query(const FBox2D& Area, TArray<AMBBaseCityObjectActor*>& OutObjects) const;
+
+	const FMBCityFootprint* FindFootprint(const AMBBaseCityObjectActor* Object) const;
+
+	// world space snap sockets of the placed object
+	const TArray<FVector>* FindSnapSockets(const AMBBaseCityObjectActor* Object) const;
+
+private:
+
+	struct FEntry
+	{
+		FMBCityFootprint Footprint;
+		TArray<FVector> SnapSockets;
+	};
+
+	void GetCellRange(const FBox2D& Area, FIntPoint& OutMinCell, FIntPoint& OutMaxCell) const;
+
+	float CellSize = 1500.0f;
+
+	TMap<FIntPoint, TArray<AMBBaseCityObjectActor*>> Cells;
+
+	TMap<const AMBBaseCityObjectActor*, FEntry> Entries;
+};
@@ -53,4 +53,13 @@ public:
 
 	UPROPERTY(EditAnywhere)
 	TSubclassOf<AMBPossibleGroundActor> PossibleGroundTileClass;
+
+protected:
+
+	// spawned tiles by ground index
+	UPROPERTY()
+	TMap<FIntPoint, AMBBaseGroundTileActor*> TileActors;
+
+	UPROPERTY()
+	TArray<AMBPossibleGroundActor*> PossibleTileActors;
 };
@@ -7,6 +7,10 @@
 #include "MergeSystem/MergeSubsystem.h"
 #include "MBGroundSubsystem.generated.h"
 
+constexpr int32 GroundStorageVersion = 1;
+
+constexpr float GroundTileSize = 3000.0f;
+
 USTRUCT(BlueprintType)
 struct FMBPossibleGroundTileInfo : public FTableRowBase
 {
@@ -65,6 +69,11 @@ public:
 
 	bool GetGroundTile(const FIntPoint& Index, FMBGroundTile& OutGroundTile);
 
+	FVector2D GetTileCenter(const FIntPoint& Index) const;
+
+	// index of the tile that contains location, it can be out of field
+	FIntPoint GetTileIndexForLocation(const FVector2D& Location) const;
+
 	UFUNCTION(BlueprintCallable)
 	void GetGroundTileInfo(const FIntPoint& Index, FMBPossibleGroundTileInfo& OutGroundTileInfo);
 
@@ -79,6 +88,10 @@ protected:
 	
 	void ParseGround(const FString& JsonString);
 
+	void SerializeGround(FArchive& Ar, int32 Version);
+
+	void ExportGroundJson();
+
 	TArray<TArray<FMBGroundTile>> GroundField;
 
 	// must be even
@@ -40,6 +40,9 @@ protected:
 	UPROPERTY(BlueprintReadOnly)
 	class ATopDownPawn* TopDownPawn;
 
+	UPROPERTY()
+	class AMBMergeFieldManager* MergeFieldManager = nullptr;
+
 	TSubclassOf<class UUserWidget> LoadingScreenClass;
 	
 public:
@@ -46,12 +46,21 @@ protected:
 	UFUNCTION(BlueprintImplementableEvent)
 	void PlayPossibleMergeAnimation(const FVector& Direction);
 
+	// stops animations that could still be playing when actor goes to the pool
+	void ResetPooledState();
+
 public:	
 
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
-	void Initialize(const FMergeFieldItem& InBaseData, const FMergeItemData& InTableData, const FIntPoint& Index);
+	void Initialize(const FMergeFieldItem& InBaseData, const FMergeItemData* InTableData, const FIntPoint& Index);
+
+	// switches actor between the field and the pool of the field manager
+	void SetPooled(bool Pooled);
+
+	// hidden actor without collision and tick, keeps its item data
+	void SetDormant(bool Dormant);
 
 	FIntPoint GetFieldIndex() { return FieldIndex; }
 	FMergeFieldItem GetBaseData() { return BaseData; }
@@ -70,4 +79,18 @@ protected:
 	FMergeItemData TableData;
 
 	FIntPoint FieldIndex;
+
+	// cell where the item is drawn by the board renderer, (-1, -1) if the actor draws its own sprite
+	FIntPoint RenderedIndex = FIntPoint(-1, -1);
+
+	// returns the item to the board renderer when animation is over
+	FTimerHandle PromoteTimerHandle;
+
+	// sprite state before any animation, restored when actor goes to the pool
+	FTransform SpriteRelativeTransform;
+	FLinearColor SpriteColor;
+
+	// manager that spawned the item
+	UPROPERTY()
+	AMBMergeFieldManager* FieldManager = nullptr;
 };
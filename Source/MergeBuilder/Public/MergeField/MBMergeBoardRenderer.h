@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PaperGroupedSpriteComponent.h"
+#include "MBMergeBoardRenderer.generated.h"
+
+class UPaperSprite;
+
+/**
+ * Draws sprites of all resting merge field items in one batch.
+ * Every field cell has its own slot, instances are rebuilt from slots once per frame if something changed.
+ */
+UCLASS()
+class MERGEBUILDER_API UMBMergeBoardRenderer : public UPaperGroupedSpriteComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UMBMergeBoardRenderer();
+
+	void SetCell(const FIntPoint& Index, UPaperSprite* Sprite, const FTransform& Transform, const FLinearColor& Color);
+
+	void ClearCell(const FIntPoint& Index);
+
+	// rebuilds sprite instances if any cell was changed
+	void FlushCells();
+
+protected:
+
+	// row-major cells, same as in the merge subsystem
+	UPROPERTY()
+	TArray<UPaperSprite*> CellSprites;
+
+	TArray<FTransform> CellTransforms;
+	TArray<FLinearColor> CellColors;
+
+	bool CellsDirty = false;
+};
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "MBBaseMergeItemActor.h"
+#include "MBMergeBoardRenderer.h"
 #include "MBCoreTypes.h"
 #include "MBMergeFieldManager.generated.h"
 
@@ -25,12 +26,33 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-	void DestroyAllItems();
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	void WarmUpPool();
+
+	// returns item actor from the pool or spawns a new one if the pool is empty
+	AMBBaseMergeItemActor* AcquireItemActor(const FTransform& Transform);
+
+	// hides item actor and returns it to the pool instead of destroying
+	void ReleaseItemActor(AMBBaseMergeItemActor* ItemActor);
+
+	// item actor draws its own sprite for animations or drag, zero duration keeps it until RestItem
+	void PromoteItem(AMBBaseMergeItemActor* Item, float Duration);
+
+	// item resting at its cell is drawn by the board renderer
+	void RestItem(AMBBaseMergeItemActor* Item);
+
+	void ShowSelectionActor(const FVector& Location);
+	void HideSelectionActor();
 
 	AMBBaseMergeItemActor* SpawnItemAtIndex(const FMergeFieldItem& Item, const FIntPoint& Index);
 
+	// spawns items that differ from the merge subsystem state and wakes up the rest
 	void InitializeField();
 
+	// keeps item actors on the field but hides them while other screen is shown
+	void SetFieldDormant();
+
 	void HandleStartTouchOnIndex(const FIntPoint& Index);
 	void HandleReleaseTouchOnIndex(const FIntPoint& Index);
 	void HandleDrag(const FVector& FieldLocation);
@@ -65,6 +87,9 @@ public:
 	UFUNCTION(BlueprintCallable)
 	bool GetLocationForIndex(const FIntPoint& Index, FVector& OutLocation);
 
+	UFUNCTION(BlueprintPure)
+	int32 GetSpawnsAvoidedByPool() const { return SpawnsAvoidedByPool; }
+
 	UFUNCTION(BlueprintCallable)
 	bool GetIndexForLocation(const FVector& Location, FIntPoint& OutIndex);
 
@@ -81,6 +106,13 @@ protected:
 
 	TArray<TArray<AMBBaseMergeItemActor*>> FieldItems;
 
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+		UMBMergeBoardRenderer* BoardRenderer;
+
+	// how long item actor is shown after animation is started
+	UPROPERTY(EditAnywhere)
+	float PromotedItemDuration = 1.0f;
+
 	UPROPERTY(EditAnywhere, BlueprintReadOnly)
 		UDataTable* MergeItemsDataTable;
 
@@ -100,6 +132,21 @@ protected:
 	UPROPERTY(BlueprintReadOnly)
 		AActor* SelectionActor;
 
+	bool SelectionShown = false;
+
+	// hidden item actors ready to be reused
+	UPROPERTY()
+	TArray<AMBBaseMergeItemActor*> ItemActorsPool;
+
+	// whole field and one spare actor
+	UPROPERTY(EditAnywhere)
+	int32 PoolWarmUpSize = MergeFieldCellsNum + 1;
+
+	UPROPERTY(EditAnywhere)
+	FVector PoolParkingLocation = FVector(0.0f, 0.0f, -10000.0f);
+
+	int32 SpawnsAvoidedByPool = 0;
+
 	UPROPERTY(EditAnywhere)
 	float TileSize = 64.0f;
 	UPROPERTY(EditAnywhere)
@@ -89,6 +89,12 @@ struct FMergeFieldItem
 	{
 		return Type != Other.Type || Level != Other.Level;
 	}
+
+	friend FArchive& operator<<(FArchive& Ar, FMergeFieldItem& Item)
+	{
+		Ar << Item.Type << Item.Level << Item.RemainItemsToSpawn << Item.IsDusty << Item.IsInBox;
+		return Ar;
+	}
 };
 
 USTRUCT(BlueprintType)
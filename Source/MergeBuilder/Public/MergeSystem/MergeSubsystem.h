@@ -6,9 +6,21 @@
 #include "MBCoreTypes.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "MergeItemData.h"
+#include "SpawnItemsSampler.h"
 #include "MergeSubsystem.generated.h"
 
-const FIntPoint MergeFieldSize = FIntPoint(7, 9);
+constexpr int32 MergeFieldWidth = 7;
+constexpr int32 MergeFieldHeight = 9;
+constexpr int32 MergeFieldCellsNum = MergeFieldWidth * MergeFieldHeight;
+
+static_assert(MergeFieldCellsNum <= 64, "Merge field cells must fit into 64-bit masks");
+
+const FIntPoint MergeFieldSize = FIntPoint(MergeFieldWidth, MergeFieldHeight);
+
+// all field changes during this time are written to storage at once
+constexpr float SaveFieldDelay = 2.0f;
+
+constexpr int32 InventoryStorageVersion = 1;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FItemAction, const FMergeFieldItem&, FieldItem);
 /**
@@ -33,12 +45,17 @@ public:
 
 	bool GetClosestFreeIndex(const FIntPoint& Index, FIntPoint& ClosestFreeIndex);
 
-	static void GetRandomItemWeight(const TArray<FSpawnItemData>& Items, FSpawnItemData& OutItem);
+	// samples spawnable items of the generator with its precompiled sampler, uses global random if stream is not set
+	bool GetRandomSpawnItem(const FMergeFieldItem& Generator, FSpawnItemData& OutItem, const FRandomStream* Stream = nullptr) const;
 
 	static int32 GetWeightForProbability(ESpawnProbability Probability);
 
 	bool HasFreePlace();
 
+	int32 GetFreePlacesNum();
+
+	bool GetFirstFreeIndex(FIntPoint& OutIndex);
+
 	int32 DecrementRemainItemsToSpawn(const FIntPoint& Index);
 
 	void InitItem(FMergeFieldItem& OutItem);
@@ -49,32 +66,118 @@ public:
 
 	void AddNewReward(const FMergeFieldItem& NewRewardItem);
 
+	// adds all items to rewards queue with one save and one OnGetReward
+	void AddNewRewards(const TArray<FMergeFieldItem>& NewRewardItems);
+
 	UFUNCTION(BlueprintCallable)
 	int32 GetItemTotalCount(const FMergeFieldItem& Item);
 
 	void SpendItems(const FMergeFieldItem& Item, int32 Count);
 
+	// marks field as changed, it will be written to storage after SaveFieldDelay
 	void SaveField();
 
+	// writes changed field to storage right now
+	void FlushField();
+
 	bool GetAllItemsInBoxAround(const FIntPoint& Index, TArray<FIntPoint>& OutItemIndexes);
 
 	void OpenInBoxItem(const FIntPoint& Index, FMergeFieldItem& OutItem);
 
+	UFUNCTION(BlueprintPure)
+	bool HasPossibleMerges() const;
+
+	// random pair of equal items where the first one is usable and the second one is not in box
+	bool GetRandomMergeablePair(FIntPoint& OutFirstIndex, FIntPoint& OutSecondIndex);
+
+	bool IsLastLevelItem(const FMergeFieldItem& Item) const;
+
+	// shared table data of the item, nullptr if there is no such type or level
+	const FMergeItemData* GetItemData(const FMergeFieldItem& Item) const;
+
+	// levels count in the items chain of the type, 0 if there is no such chain
+	int32 GetItemMaxLevel(EMergeItemType Type) const;
+
 protected:
 
+	void BuildItemsCatalog();
+
 	void InitFieldFromStartTable();
 
 	void ParseField(const FString& JsonString);
 
+	void WriteField();
+
+	void SerializeField(FArchive& Ar, int32 Version);
+
+	void ExportFieldJson();
+
 	void SetItemAt(const FIntPoint& Index, const FMergeFieldItem& Item);
 
 	bool TryMergeItems(const FMergeFieldItem& Item, const FIntPoint& MergeIndex, FMergeFieldItem& MergedItem);
 
-	void GetAllIndexVariants(int32 IndexSum, TArray<FIntPoint>& Variants);
+	void ClearField();
+
+	// writes item into the cell and keeps cell masks in sync
+	void WriteCell(int32 Cell, const FMergeFieldItem& Item);
 
-	TArray<TArray<FMergeFieldItem>> MergeField;
+	static void RemoveItemCell(TMap<uint64, uint64>& ItemCells, uint64 ItemKey, uint64 Bit);
+
+	void UpdateMergeableKey(const FMergeFieldItem& Item);
+
+	static int32 GetRandomCell(uint64 Cells);
+
+	static bool IsValidIndex(const FIntPoint& Index)
+	{
+		return Index.X >= 0 && Index.Y >= 0 && Index.X < MergeFieldWidth && Index.Y < MergeFieldHeight;
+	}
+
+	static int32 IndexToCell(const FIntPoint& Index) { return Index.Y * MergeFieldWidth + Index.X; }
+	static FIntPoint CellToIndex(int32 Cell) { return FIntPoint(Cell % MergeFieldWidth, Cell / MergeFieldWidth); }
+	static uint64 CellBit(int32 Cell) { return 1ull << Cell; }
+
+	uint64 GetFreeMask() const { return ~OccupiedMask & FieldMask; }
+	// not dusty and not in box items
+	uint64 GetUsableMask() const { return OccupiedMask & ~DustyMask & ~InBoxMask; }
+
+	// same key for items that are equal by type and level
+	static uint64 GetItemKey(const FMergeFieldItem& Item) { return ((uint64)Item.Type << 32) | (uint32)Item.Level; }
+
+	static constexpr uint64 FieldMask = MergeFieldCellsNum == 64 ? ~0ull : (1ull << MergeFieldCellsNum) - 1;
+
+	// row-major cells, cell = Y * MergeFieldWidth + X
+	FMergeFieldItem MergeField[MergeFieldCellsNum];
+
+	uint64 OccupiedMask = 0;
+	uint64 DustyMask = 0;
+	uint64 InBoxMask = 0;
+
+	// cells of usable (not dusty and not in box) items by item key,
+	// cells count is the amount of such items on the field
+	TMap<uint64, uint64> UsableItemCells;
+
+	// cells of dusty and usable items by item key
+	TMap<uint64, uint64> NotInBoxItemCells;
+
+	// keys of not last level items that have a pair to merge
+	TArray<uint64> MergeableItemKeys;
 
 	TArray<FMergeFieldItem> RewardsQueue;
+
+	bool FieldDirty = false;
+
+	FTimerHandle SaveFieldTimerHandle;
+
+	FDelegateHandle PreCommitHandle;
+
+	// table data of all items, chains are stored one after another in item type order
+	TArray<const FMergeItemData*> ItemsCatalog;
+
+	// spawnable items samplers with the same indexes as ItemsCatalog
+	TArray<FSpawnItemsSampler> ItemSamplers;
+
+	// offset of every item type chain in ItemsCatalog, last element is the catalog size
+	TArray<int32> ItemChainOffsets;
 	
 public:
 	UPROPERTY()
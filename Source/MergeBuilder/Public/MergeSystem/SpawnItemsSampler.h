@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MergeItemData.h"
+
+/**
+ * Alias table over spawnable items of a generator.
+ * Probability type weight is shared equally between items of this type.
+ */
+struct MERGEBUILDER_API FSpawnItemsSampler
+{
+	void Build(const TArray<FSpawnItemData>& InItems);
+
+	bool IsEmpty() const { return Items == nullptr; }
+
+	// uses global random if stream is not set
+	const FSpawnItemData& Sample(const FRandomStream* Stream = nullptr) const;
+
+private:
+
+	// items array of the table row this sampler was built from
+	const TArray<FSpawnItemData>* Items = nullptr;
+
+	TArray<float> Probabilities;
+	TArray<int32> Aliases;
+};
@@ -8,6 +8,8 @@
 #include "CitySystem/CityObjectsData.h"
 #include "MBQuestSubsystem.generated.h"
 
+constexpr int32 QuestsStorageVersion = 1;
+
 /**
  * 
  */
@@ -49,6 +51,10 @@ protected:
 	void InitQuests();
 
 	void ParseQuests(const FString& JsonString);
+
+	void SerializeQuests(FArchive& Ar, int32 Version);
+
+	void ExportQuestsJson();
 	
 	void GenerateNewQuests();
 
@@ -76,11 +82,14 @@ protected:
 	UFUNCTION()
 	void UpdateCityObjectBuildQuests(FName NewBuildObject);
 
-	void CheckRefreshQuestsTimer();
+	void CheckRefreshQuests();
+
+	// refresh is called by time subsystem when DateTo is reached
+	void ScheduleQuestsRefresh();
 
 	void GetPossibleItemTypes(TArray<EMergeItemType>& OutItemTypes);
 
-	void GetQuestObjects(TMap<FName, FCityObjectData*>& OutObjects);
+	void GetQuestObjects(TMap<FName, const FCityObjectData*>& OutObjects);
 
 	void GenerateNewQuest(FQuestData& Quest);
 
@@ -90,7 +99,7 @@ private:
 
 	FDelegateHandle OnGetTimeDelegateHandle;
 
-	FTimerHandle QuestRefreshTimerHandle;
+	int32 RefreshDeadlineID = 0;
 
 protected:
 
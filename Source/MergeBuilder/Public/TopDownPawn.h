@@ -48,6 +48,8 @@ public:
 	bool GetWorldObjectHitResult(const ETouchIndex::Type FingerIndex, FHitResult& HitResult);
 	bool GetMultiWorldObjectHitResults(const ETouchIndex::Type FingerIndex, TArray<FHitResult>& HitResults);
 
+	class AMBCityBuilderManager* GetCityManager();
+
 protected:
 
 	UPROPERTY(BlueprintReadOnly, EditAnywhere)
@@ -72,4 +74,7 @@ protected:
 	FVector PrevMoveLocation1;
 	
 	bool TwoFingersTouch = false;
+
+	UPROPERTY()
+	class AMBCityBuilderManager* CityBuilderManager = nullptr;
 };
@@ -6,6 +6,8 @@
 #include "UObject/NoExportTypes.h"
 #include "MBTutorialSubsystem.generated.h"
 
+constexpr int32 TutorialStorageVersion = 1;
+
 /**
  * 
  */
@@ -39,6 +41,10 @@ protected:
 
 	void SaveProgress();
 
+	void SerializeProgress(FArchive& Ar, int32 Version);
+
+	void ExportProgressJson();
+
 	UFUNCTION()
 	void StartTutorial();
 
@@ -9,7 +9,37 @@
 #include "MergeSystem/MergeSubsystem.h"
 #include "AccountSubsystem.generated.h"
 
+// resources that are given to the player at once
+USTRUCT(BlueprintType)
+struct FRewardGrant
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Experience = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 SoftCoins = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 PremCoins = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Energy = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	TArray<FMergeFieldItem> Items;
+
+	// levels gained by the experience, filled when grant is applied
+	UPROPERTY(BlueprintReadOnly)
+	int32 NewLevels = 0;
+};
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnGetResource, int32, ResourceAmount);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnRewardsGranted, const FRewardGrant&, Grant);
+
+constexpr int32 AccountStorageVersion = 2;
+
 /**
  * 
  */
@@ -55,11 +85,9 @@ protected:
 	UPROPERTY(BlueprintReadOnly)
 	bool InfiniteEnergy = false;
 
+	// energy below max is restored by time, it's full at this time
 	UPROPERTY()
-	FTimerHandle EnergyRestoreTimerHandle;
-
-	UPROPERTY()
-	FDateTime LastSaveTime;
+	FDateTime EnergyFullTime;
 
 	bool IsInitialized = false;
 
@@ -72,13 +100,19 @@ public:
 	inline int32 GetExperience() { return Experience; }
 	inline int32 GetSoftCoins() { return SoftCoins; }
 	inline int32 GetPremCoins() { return PremCoins; }
-	inline int32 GetEnergy() { return Energy; }
+
+	// current energy with the restored units, doesn't change the account
+	UFUNCTION(BlueprintPure)
+	int32 GetEnergy() const;
 
 	void AddExperience(int32 DeltaExperience);
 	void AddSoftCoins(int32 DeltaCoins);
 	void AddPremCoins(int32 DeltaCoins);
 	void AddEnergy(int32 DeltaEnergy);
 
+	// applies all resources with one save, items and level rewards go to the rewards queue together
+	void GrantRewards(const FRewardGrant& Grant);
+
 	void SaveAccount();
 
 	bool HasEnoughEnergy(int32 EnergyToSpend);
@@ -94,22 +128,31 @@ protected:
 
 	void ParseAccount(const FString& JsonString);
 
+	void SerializeAccount(FArchive& Ar, int32 Version);
+
+	void ExportAccountJson();
+
 	UFUNCTION()
 	void InitAccount();
 
-	void InitEnergy(int32 OldEnergy, FDateTime OldTime, float OldRemainTime);
-	int32 GetMaxExperienceForLevel(int32 InLevel);
-	// -1 for NextRestoreTime means default restore time
-	void StartRestoreEnergy(float NextRestoreTime = -1.0f);
+	void InitEnergyFullTime(const FDateTime& SaveTime, float RemainRestoreSeconds);
+
+	// applies energy restored since the last update and broadcasts it
+	void UpdateEnergy();
+
+	// deadline at the time the next unit of energy is restored
+	void ScheduleEnergyRestore();
 
-	void RestoreEnergy();
+	int32 GetMaxExperienceForLevel(int32 InLevel);
 
-	void LevelUp();
+	void LevelUp(TArray<FMergeFieldItem>& OutRewards);
 
 private:
 
 	FDelegateHandle OnGetTimeDelegateHandle;
 
+	int32 EnergyDeadlineID = INDEX_NONE;
+
 public:
 
 	UPROPERTY(BlueprintAssignable)
@@ -126,4 +169,7 @@ public:
 
 	UPROPERTY(BlueprintAssignable)
 	FOnGetResource OnGetEnergy;
+
+	UPROPERTY(BlueprintAssignable)
+	FOnRewardsGranted OnRewardsGranted;
 };
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonWriter.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+
+using FMBJsonWriter = TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>;
+using FMBJsonReader = TJsonReader<TCHAR>;
+
+/**
+ * Writes UStructs straight to json writer and reads them from json tokens, without json object tree.
+ * Keys and values are the same as FJsonObjectConverter writes, so old storage files stay readable.
+ */
+class MERGEBUILDER_API FMBJsonCodec
+{
+public:
+
+	static TSharedRef<FMBJsonWriter> CreateWriter(FString& OutString);
+	static TSharedRef<FMBJsonReader> CreateReader(const FString& JsonString);
+
+	static void WriteStruct(FMBJsonWriter& Writer, const UStruct* Struct, const void* Data);
+	static void WriteStruct(FMBJsonWriter& Writer, const FString& Identifier, const UStruct* Struct, const void* Data);
+
+	// object start must be already read, reads to the matching object end
+	static bool ReadStruct(FMBJsonReader& Reader, const UStruct* Struct, void* Data);
+
+	// skips the value which notation was just read
+	static bool SkipValue(FMBJsonReader& Reader, EJsonNotation Notation);
+
+	// value of the current token, numbers and bools are converted like FJsonValue does
+	static FString GetValueAsString(const FMBJsonReader& Reader, EJsonNotation Notation);
+	static double GetValueAsNumber(const FMBJsonReader& Reader, EJsonNotation Notation);
+	static bool GetValueAsBool(const FMBJsonReader& Reader, EJsonNotation Notation);
+
+	template <typename TStruct>
+	static void WriteStruct(FMBJsonWriter& Writer, const TStruct& Struct)
+	{
+		WriteStruct(Writer, TStruct::StaticStruct(), &Struct);
+	}
+
+	template <typename TStruct>
+	static void WriteStruct(FMBJsonWriter& Writer, const FString& Identifier, const TStruct& Struct)
+	{
+		WriteStruct(Writer, Identifier, TStruct::StaticStruct(), &Struct);
+	}
+
+	template <typename TStruct>
+	static bool ReadStruct(FMBJsonReader& Reader, TStruct& Struct)
+	{
+		return ReadStruct(Reader, TStruct::StaticStruct(), &Struct);
+	}
+
+	// array start must be already read, reads to the matching array end.
+	// structs with fields failed to read are kept partly read, like FJsonObjectConverter does, only non-objects are skipped
+	template <typename TStruct>
+	static bool ReadStructArray(FMBJsonReader& Reader, TArray<TStruct>& OutStructs)
+	{
+		bool Result = true;
+
+		EJsonNotation Notation = EJsonNotation::None;
+		while (Reader.ReadNext(Notation) && Notation != EJsonNotation::ArrayEnd)
+		{
+			if (Notation != EJsonNotation::ObjectStart)
+			{
+				SkipValue(Reader, Notation);
+				Result = false;
+				continue;
+			}
+
+			TStruct Struct;
+			if (!ReadStruct(Reader, Struct))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("FMBJsonCodec::ReadStructArray() - %s at index %d is read partly"), *TStruct::StaticStruct()->GetName(), OutStructs.Num());
+				Result = false;
+			}
+
+			OutStructs.Add(MoveTemp(Struct));
+		}
+
+		return Result && Notation == EJsonNotation::ArrayEnd;
+	}
+};
@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Async/Future.h"
+
+struct FMBStorageSection
+{
+	int32 SchemaVersion = 0;
+	int32 UE4Version = 0;
+	int32 LicenseeUE4Version = 0;
+
+	TArray<uint8> Data;
+
+	friend FArchive& operator<<(FArchive& Ar, FMBStorageSection& Section)
+	{
+		Ar << Section.SchemaVersion << Section.UE4Version << Section.LicenseeUE4Version << Section.Data;
+		return Ar;
+	}
+};
+
+// gets names of the sections found in the snapshot
+using FOnSnapshotPreloaded = TUniqueFunction<void(const TSet<FString>& SectionNames)>;
+
+/**
+ * Keeps binary storage of all subsystems as sections of one snapshot file.
+ * Sections changed during a frame are committed with one atomic write at the end of the frame.
+ */
+class MERGEBUILDER_API FMBSaveCoordinator
+{
+public:
+
+	static FMBSaveCoordinator& Get();
+
+	// starts reading the snapshot on a worker thread, first ReadSection waits for it.
+	// callback is called on the worker thread after the snapshot is read, or right away if it's already loaded
+	void Preload(FOnSnapshotPreloaded OnPreloaded = nullptr);
+
+	// section of the last loaded or written snapshot
+	const FMBStorageSection* ReadSection(const FString& Name);
+
+	void WriteSection(const FString& Name, FMBStorageSection&& Section);
+
+	// writes changed sections right now instead of the end of the frame
+	void Commit();
+
+	uint64 GetGeneration() const { return Generation; }
+
+	// broadcast before every commit, owners of delayed sections write them here to get into the same snapshot
+	FSimpleMulticastDelegate OnPreCommit;
+
+private:
+
+	// storage file with header and CRC checked payload
+	static bool ReadStorageFile(const FString& FilePath, FMBStorageSection& OutSection);
+	static void WriteStorageFile(const FString& FilePath, const FMBStorageSection& Section);
+
+	struct FSnapshot
+	{
+		uint64 Generation = 0;
+		TMap<FString, FMBStorageSection> Sections;
+	};
+
+	void LoadSnapshot();
+
+	static bool ReadSnapshot(FSnapshot& OutSnapshot);
+
+	bool HandleCommitTick(float DeltaTime);
+
+	TMap<FString, FMBStorageSection> Sections;
+
+	bool SnapshotLoaded = false;
+	bool SnapshotDirty = false;
+
+	// incremented on every commit
+	uint64 Generation = 0;
+
+	FDelegateHandle CommitTickHandle;
+
+	TFuture<FSnapshot> PreloadedSnapshot;
+};
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+
+/**
+ * Reads storage in worker tasks when the game starts, before subsystems are initialized.
+ * Subsystems take the prepared data instead of reading files on the game thread.
+ */
+class MERGEBUILDER_API FMBStartupLoader
+{
+public:
+
+	static FMBStartupLoader& Get();
+
+	// reads the save snapshot, then json of the storages which are not in the snapshot yet
+	void Start(const TArray<FString>& StorageNames);
+
+	// waits for the json storage read if it is not finished, returns false if the storage was not prefetched
+	bool TakeJsonStorage(const FString& StorageName, TOptional<FString>& OutData);
+
+	// drops the prefetched json which is outdated after a new save
+	void DiscardJsonStorage(const FString& StorageName);
+
+	// logs time from the start of loading until the game can be played
+	void MarkInteractive();
+
+private:
+
+	TMap<FString, TFuture<TOptional<FString>>> JsonReads;
+
+	double StartTime = 0.0;
+
+	bool InteractiveMarked = false;
+};
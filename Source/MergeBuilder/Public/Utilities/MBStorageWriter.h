@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Writes storage files on a background thread.
+ * Only the latest data of every file is written, files are replaced through a temp file.
+ */
+class MERGEBUILDER_API FMBStorageWriter
+{
+public:
+
+	static FMBStorageWriter& Get();
+
+	void Write(const FString& FilePath, TArray<uint8>&& Data);
+
+	// blocks until all queued data is on disk
+	void Flush();
+
+private:
+
+	// writes one queued file, returns false if the queue is empty
+	bool WriteNext();
+
+	static void WriteFile(const FString& FilePath, const TArray<uint8>& Data);
+
+	FCriticalSection QueueLock;
+
+	// held while a file is written so Flush can't pass an unfinished write
+	FCriticalSection FileLock;
+
+	TMap<FString, TArray<uint8>> PendingWrites;
+
+	bool WorkerActive = false;
+};
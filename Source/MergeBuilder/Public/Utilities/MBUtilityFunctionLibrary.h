@@ -7,6 +7,9 @@
 #include "Kismet/BlueprintFunctionLibrary.h"
 #include "MBUtilityFunctionLibrary.generated.h"
 
+// serializes storage data, Ar is loading or saving, SchemaVersion is the version of data in storage
+using FStorageSerializer = TFunctionRef<void(FArchive& Ar, int32 SchemaVersion)>;
+
 /**
  * 
  */
@@ -22,8 +25,19 @@ public:
 	UFUNCTION(BlueprintCallable)
 	static void SaveToStorage(const FString& StorageName, const FString& Data);
 
+	static FString GetJsonStoragePath(const FString& StorageName);
+
+	// same bytes as FFileHelper::SaveStringToFile with auto detected encoding, ansi or utf-16 with BOM
+	static void EncodeStorageString(const FString& Data, TArray<uint8>& OutFileData);
+
+	// returns false if the save snapshot has no such storage or it is corrupted
+	static bool ReadBinaryFromStorage(const FString& StorageName, FStorageSerializer Serializer);
+	static void SaveBinaryToStorage(const FString& StorageName, int32 SchemaVersion, FStorageSerializer Serializer);
+
+	// json copies of binary storage are written only for debugging
+	static bool IsJsonExportEnabled();
+
 	static bool StringToJsonObject(const FString& JsonString, TSharedPtr<FJsonObject>& OutObject);
-	static void JsonObjectToString(TSharedPtr<FJsonObject> JsonObject, FString& OutString);
 
 	UFUNCTION(BlueprintCallable)
 		static const FString EnumToString(const FString& Enum, int32 EnumValue);
@@ -43,6 +57,37 @@ public:
 	static FString GetDeviceID();
 };
 
+// tagged properties serialization, tolerates added and removed struct properties
+template <typename TStruct>
+void SerializeStruct(FArchive& Ar, TStruct& Struct)
+{
+	TStruct::StaticStruct()->SerializeItem(Ar, &Struct, nullptr);
+}
+
+template <typename TStruct>
+void SerializeStructArray(FArchive& Ar, TArray<TStruct>& Structs)
+{
+	int32 Num = Structs.Num();
+	Ar << Num;
+
+	if (Ar.IsLoading())
+	{
+		if (Num < 0)
+		{
+			Ar.SetError();
+			return;
+		}
+
+		Structs.Reset(Num);
+		Structs.AddDefaulted(Num);
+	}
+
+	for (auto& Struct : Structs)
+	{
+		SerializeStruct(Ar, Struct);
+	}
+}
+
 template <typename T>
 void Shuffle(TArray<T> &arr)
 {
@@ -8,6 +8,8 @@
 #include "AndroidPlayBillingSubsystem.h"
 #include "ShopSubsystem.generated.h"
 
+constexpr int32 ShopHistoryStorageVersion = 1;
+
 UENUM(BlueprintType)
 enum class EShopCategory : uint8
 {
@@ -75,6 +77,7 @@ struct FPurchaseHistory
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnPurchaseResult, const FString&, ProductID);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnStoreProductsReceived);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnPurchaseLimitsReset);
 /**
  * 
  */
@@ -109,6 +112,10 @@ protected:
 
 	void SaveHistory();
 
+	void ExportHistoryJson();
+
+	void SchedulePurchaseLimitsReset();
+
 	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable)
 	void RequestStoreProductsInfo();
 
@@ -144,6 +151,9 @@ public:
 	UPROPERTY(BlueprintCallable, BlueprintAssignable)
 	FOnStoreProductsReceived OnStoreProductsReceivedFailed;
 
+	UPROPERTY(BlueprintAssignable)
+	FOnPurchaseLimitsReset OnPurchaseLimitsReset;
+
 protected:
 
 	UPROPERTY(BlueprintReadWrite)
@@ -157,4 +167,6 @@ protected:
 
 	UPROPERTY(BlueprintReadOnly)
 	TArray<FPurchaseHistory> ProductsHistory;
+
+	int32 LimitsResetDeadlineID = 0;
 };
@@ -4,13 +4,41 @@
 
 #include "CoreMinimal.h"
 #include "Subsystems/GameInstanceSubsystem.h"
+#include "Interfaces/IHttpRequest.h"
 #include "MBCoreTypes.h"
 #include "TimeSubsystem.generated.h"
 
+constexpr int32 TimeStorageVersion = 1;
+
+USTRUCT()
+struct FTimeEndpoint
+{
+	GENERATED_BODY()
+
+	FTimeEndpoint() {}
+
+	FTimeEndpoint(const FString& InURL, const FString& InDateTimeField, bool InWithSSL = true)
+		: URL(InURL), DateTimeField(InDateTimeField), WithSSL(InWithSSL) {}
+
+	// without scheme, like other web scripts
+	UPROPERTY()
+	FString URL;
+
+	// response json field with ISO 8601 UTC time
+	UPROPERTY()
+	FString DateTimeField;
+
+	UPROPERTY()
+	bool WithSSL = true;
+};
+
 /**
- * 
+ * Server UTC time, counted from the last anchor with the platform clock.
+ * Starts from the offset to device clock trusted on the last sync,
+ * so the game doesn't wait for the server, and verifies it by requesting all endpoints at once.
+ * Endpoints are set in [/Script/MergeBuilder.TimeSubsystem] of Game config, local server can be used for testing.
  */
-UCLASS()
+UCLASS(Config=Game)
 class MERGEBUILDER_API UTimeSubsystem : public UGameInstanceSubsystem
 {
 	GENERATED_BODY()
@@ -26,12 +54,34 @@ public:
 	UFUNCTION(BlueprintCallable)
 	const FDateTime& GetUTCNow();
 
+	// callback is called once when server time reaches the deadline, returns id for RemoveDeadline
+	int32 AddDeadline(const FDateTime& Time, FSimpleDelegate Callback);
+
+	void RemoveDeadline(int32 DeadlineID);
+
 protected:
 
 	UFUNCTION()
 	void RequestTime();
 
-	void RecalculateTime();
+	void HandleTimeResponse(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bSuccessful, int32 Round, FTimeEndpoint Endpoint);
+
+	bool ParseServerTime(FHttpResponsePtr Response, const FTimeEndpoint& Endpoint, FDateTime& OutTime) const;
+
+	void SetServerTime(const FDateTime& ServerTime);
+
+	void SetAnchor(const FDateTime& AnchorTime);
+
+	UFUNCTION()
+	void HandleEnterBackground();
+
+	UFUNCTION()
+	void HandleEnterForeground();
+
+	// calls all deadlines which are already reached in one batch, only by time confirmed by server
+	void FireElapsedDeadlines();
+
+	void ScheduleNextDeadline();
 
 public:
 
@@ -41,16 +91,56 @@ protected:
 
 	bool TimeValid = false;
 
+	// time was confirmed by server in this session
+	bool TimeVerified = false;
+
+	// last value returned by GetUTCNow
 	UPROPERTY()
 	FDateTime TimeUTC;
 
-	FTimerHandle RecalculationTimer;
+	FDateTime AnchorUTC;
+
+	// platform seconds when AnchorUTC was taken
+	double AnchorSeconds = 0.0;
+
+	// server time minus device time on the last sync
+	FTimespan TrustedOffset;
+
+	// time of the last fired deadlines, server time can't move the clock behind it
+	FDateTime FiredUTC;
+
+	UPROPERTY(Config)
+	TArray<FTimeEndpoint> TimeEndpoints;
 
-	TMap<FString, FString> TimeAPI_URLs;
-	
-	TMap<FString, FString> RemainURLs;
+	UPROPERTY(Config)
+	float RetryDelay = 1.0f;
+
+	// responses of older request rounds are ignored
+	int32 RequestRound = 0;
+
+	int32 PendingRequests = 0;
+
+	struct FDeadline
+	{
+		FDateTime Time;
+		int32 ID;
+
+		bool operator<(const FDeadline& Other) const { return Time < Other.Time; }
+	};
+
+	// min heap by time, removed deadlines stay in heap until they are popped
+	TArray<FDeadline> Deadlines;
+
+	TMap<int32, FSimpleDelegate> DeadlineCallbacks;
+
+	int32 LastDeadlineID = 0;
+
+	FTimerHandle DeadlineTimerHandle;
 
 public:
 
 	bool IsTimeValid() { return TimeValid; };
+
+	// trusted offset follows the device clock, so anything granted by time must wait for verified time
+	bool IsTimeVerified() const { return TimeVerified; }
 };